@@ -59,60 +59,93 @@ document.addEventListener('DOMContentLoaded', function () {
     return;
   }
 
-  // Throttle/debounce utility
-  function debounce(func, wait) {
-    let timeout;
-    let lastArgs;
-    let lastTime = 0;
-    const throttleWait = 50; // Minimum time between updates (ms)
-
-    return function executedFunction() {
-      const args = arguments;
-      const now = Date.now();
-
-      // Clear the previous timeout
-      if (timeout) {
-        clearTimeout(timeout);
-      }
+  // Real-time channel: 3-byte binary frames (r, g, b) over /ws, at most one
+  // per animation frame. The lamp applies only the newest frame per tick and
+  // echoes the applied color plus lock status changes back to every page.
+  const ECHO_HOLDOFF_MS = 300; // Ignore echoes while the user is dragging
+  let socket = null;
+  let pendingColor = null;
+  let frameScheduled = false;
+  let lastLocalChange = 0;
+  let applyingRemote = false;
+
+  function connectSocket() {
+    socket = new WebSocket('ws://' + window.location.host + '/ws');
+    socket.binaryType = 'arraybuffer';
 
-      // If enough time has passed, execute immediately
-      if (now - lastTime >= throttleWait) {
-        func.apply(this, args);
-        lastTime = now;
-      } else {
-        // Otherwise, set up a debounced call
-        lastArgs = args;
-        timeout = setTimeout(() => {
-          func.apply(this, lastArgs);
-          lastTime = Date.now();
-        }, wait);
+    socket.onmessage = function (event) {
+      if (typeof event.data === 'string') {
+        showLockStatus(JSON.parse(event.data).unlocked);
+        return;
+      }
+      const rgb = new Uint8Array(event.data);
+      if (rgb.length !== 3 || Date.now() - lastLocalChange < ECHO_HOLDOFF_MS) {
+        return;
       }
+      applyingRemote = true;
+      colorPicker.color.rgb = { r: rgb[0], g: rgb[1], b: rgb[2] };
+      applyingRemote = false;
+    };
+
+    socket.onclose = function () {
+      // Retry quietly; POST and polling cover the gap
+      setTimeout(connectSocket, 2000);
     };
   }
 
-  // Debounced update function
-  const updateColor = debounce(function (color) {
+  function socketOpen() {
+    return socket && socket.readyState === WebSocket.OPEN;
+  }
+
+  function sendFrame() {
+    frameScheduled = false;
+    if (!pendingColor) {
+      return;
+    }
+    const rgb = pendingColor;
+    pendingColor = null;
+
+    if (socketOpen()) {
+      socket.send(new Uint8Array([rgb.r, rgb.g, rgb.b]));
+      return;
+    }
+
+    // Fallback while the socket is down
     fetch("/postRGB", {
       method: "POST",
       headers: {
         'Content-Type': 'application/x-www-form-urlencoded',
       },
-      body: "r=" + color.rgb.r + "&g=" + color.rgb.g + "&b=" + color.rgb.b
+      body: "r=" + rgb.r + "&g=" + rgb.g + "&b=" + rgb.b
     })
       .then(response => {
         if (!response.ok) {
           throw new Error('Network response was not ok');
         }
-        console.log('Color updated');
       })
       .catch(error => console.error('Error updating color:', error));
-  }, 100); // 100ms debounce time
+  }
 
   // Color change handler
   colorPicker.on('color:change', function (color) {
-    updateColor(color);
+    if (applyingRemote) {
+      return;
+    }
+    lastLocalChange = Date.now();
+    pendingColor = color.rgb;
+    if (!frameScheduled) {
+      frameScheduled = true;
+      window.requestAnimationFrame(sendFrame);
+    }
   });
 
+  function showLockStatus(unlocked) {
+    lockStatus.className = 'status-indicator ' + (unlocked ? 'status-unlocked' : 'status-locked');
+    lockStatusText.textContent = unlocked ? 'FULL POWER MODE' : 'SAFE MODE';
+    unlockButton.disabled = unlocked;
+    resetButton.style.display = unlocked ? 'inline-block' : 'none';
+  }
+
   function updateLockStatus() {
     fetch('/lockStatus')
       .then(response => {
@@ -122,12 +155,7 @@ document.addEventListener('DOMContentLoaded', function () {
         return response.json();
       })
       .then(data => {
-        console.log('Lock status response:', data); // Debug logging
-        const unlocked = data.unlocked;
-        lockStatus.className = 'status-indicator ' + (unlocked ? 'status-unlocked' : 'status-locked');
-        lockStatusText.textContent = unlocked ? 'FULL POWER MODE' : 'SAFE MODE';
-        unlockButton.disabled = unlocked;
-        resetButton.style.display = unlocked ? 'inline-block' : 'none';
+        showLockStatus(data.unlocked);
       })
       .catch(error => {
         console.error('Error checking lock status:', error);
@@ -184,8 +212,13 @@ document.addEventListener('DOMContentLoaded', function () {
     }
   });
 
-  // Initial status check
+  // Initial status check; after that the socket pushes changes, and polling
+  // only runs while it is disconnected
   updateLockStatus();
-  // Poll every 5 seconds
-  setInterval(updateLockStatus, 5000);
+  setInterval(function () {
+    if (!socketOpen()) {
+      updateLockStatus();
+    }
+  }, 5000);
+  connectSocket();
 });
\ No newline at end of file
@@ -14,6 +14,40 @@
 #define DEVICE_NAME "Color Shadow Lamp"
 #define DEVICE_ID "color_shadow_lamp_01"  // Must be unique if you have multiple devices
 
+// State updates to Home Assistant that land within this window of the last
+// publish are merged into one; the final state is always flushed retained
+#define STATE_PUBLISH_WINDOW_MS 250
+
+// Diagnostic sensors (loop time, heap, RSSI, reconnects, command latency)
+// are aggregated to min/avg/max and published once per period
+#define TELEMETRY_PUBLISH_PERIOD_MS 60000
+
+// Persistent settings live in RAM and are committed to NVS in one batch
+// once changes have settled, or at the latest after the max delay. The
+// namespace predates the settings store and keeps existing unlock flags.
+#define SETTINGS_NAMESPACE "led"
+#define SETTINGS_SETTLE_MS 2000
+#define SETTINGS_MAX_DELAY_MS 30000
+
+// LED power model for the thermal governor: drive current and forward
+// voltage of each channel at full duty, and the heat sink time constant.
+// The mode/unlock limits in LEDController are sustained power; output runs
+// up to the peak cap (80% locked, full unlocked) until the model reaches
+// POWER_DERATE_KNEE of that, so bursts last roughly half a time constant.
+#define POWER_RED_MA 350
+#define POWER_RED_VF 2.2f
+#define POWER_GREEN_MA 350
+#define POWER_GREEN_VF 3.2f
+#define POWER_BLUE_MA 350
+#define POWER_BLUE_VF 3.2f
+#define POWER_THERMAL_TAU_MS 60000
+#define POWER_DERATE_KNEE 0.8f
+
+// Temporal dither tick. Fractions of an 11-bit step repeat every 16 ticks
+// at most, so the slowest ripple is 1e6 / (16 * tick) Hz - 250 Hz at 250 us.
+// The timer only runs while a channel sits between two 11-bit duties.
+#define DITHER_TICK_US 250
+
 // Home Assistant MQTT Discovery Configuration
 // These topics follow the Home Assistant MQTT Light integration format
 // Base topic: homeassistant/light/{device_id}/
@@ -0,0 +1,188 @@
+#ifndef COLOR_PIPELINE_H
+#define COLOR_PIPELINE_H
+
+#include <stdint.h>
+#include "PwmTables.h"
+#include "ColorTemperature.h"
+
+// One path from any color source to the LEDs:
+//
+//   source -> ColorState -> linear -> correction -> clamp -> trim -> power -> output
+//
+// Every input (Home Assistant, the web UI, the knobs, LTT, effects, fades)
+// first becomes a LinearColor: linear light per channel on the fine-duty
+// scale, gamma already expanded, nothing trimmed. The stages in between are
+// empty structs with a static apply(), chained by ColorPipeline<...> at
+// compile time, so the whole chain inlines into one pass over three ints
+// with no table or pointer per stage. Power (PowerGovernor) and output
+// (TemporalDither + the latched LedOutput) keep per-lamp state and stay in
+// LEDController::writeDutiesFine(), which every pipeline ends in.
+
+// 3x3 color correction applied to linear light, rows are the red, green and
+// blue outputs. Identity compiles to nothing; e.g. pull some red out of
+// green to desaturate a greenish emitter. Keep each row's absolute sum
+// within 3.
+static constexpr float COLOR_CORRECTION[COLOR_CHANNELS][COLOR_CHANNELS] = {
+    {1.0f, 0.0f, 0.0f},
+    {0.0f, 1.0f, 0.0f},
+    {0.0f, 0.0f, 1.0f},
+};
+
+// Linear light per channel, 0..PWM_FINE_MAX at full scale
+struct LinearColor {
+    int c[COLOR_CHANNELS] = {0};
+};
+
+// What the lamp was asked to show, kept apart from the duties it renders
+// to. The color is stored at full brightness as Home Assistant sends it and
+// the brightness separately, so dimming never rounds the color ratios away.
+// kelvin is nonzero in color temperature mode, and rgb is then unused.
+struct ColorState {
+    uint8_t rgb[COLOR_CHANNELS] = {255, 255, 255};
+    uint8_t brightness = 255;
+    uint16_t kelvin = 0;
+
+    bool operator==(const ColorState& other) const {
+        return rgb[0] == other.rgb[0] && rgb[1] == other.rgb[1] && rgb[2] == other.rgb[2] &&
+               brightness == other.brightness && kelvin == other.kelvin;
+    }
+    bool operator!=(const ColorState& other) const { return !(*this == other); }
+};
+
+constexpr uint8_t clampColor8(int value) {
+    return static_cast<uint8_t>(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+namespace pipeline_detail {
+
+static constexpr int CORRECTION_SHIFT = 12;
+
+struct CorrectionQ12 {
+    int m[COLOR_CHANNELS][COLOR_CHANNELS] = {};
+    bool identity = true;
+
+    constexpr CorrectionQ12() {
+        for (int row = 0; row < COLOR_CHANNELS; row++) {
+            for (int col = 0; col < COLOR_CHANNELS; col++) {
+                float v = COLOR_CORRECTION[row][col];
+                m[row][col] = static_cast<int>(v * (1 << CORRECTION_SHIFT) + (v < 0.0f ? -0.5f : 0.5f));
+                identity = identity && m[row][col] == (row == col ? 1 << CORRECTION_SHIFT : 0);
+            }
+        }
+    }
+};
+
+inline constexpr CorrectionQ12 CORRECTION{};
+
+// The largest magnitude a row can reach is its absolute sum times full
+// scale; that sum of three products has to fit int32
+constexpr bool correctionFits() {
+    for (int row = 0; row < COLOR_CHANNELS; row++) {
+        int64_t gain = 0;
+        for (int col = 0; col < COLOR_CHANNELS; col++) {
+            int v = CORRECTION.m[row][col];
+            gain += v < 0 ? -v : v;
+        }
+        if (gain > 3 << CORRECTION_SHIFT || gain * PWM_FINE_MAX > INT32_MAX) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(correctionFits(), "COLOR_CORRECTION row sums within 3");
+
+}  // namespace pipeline_detail
+
+// Sources: a LinearColor from each kind of input
+namespace color_source {
+
+// 8-bit color with an 8-bit brightness, both gamma encoded
+inline LinearColor fromColor8(const uint8_t rgb[COLOR_CHANNELS], uint8_t brightness = 255) {
+    LinearColor color;
+    int level = PWM_TABLES.level8Fine[brightness];
+    for (int c = 0; c < COLOR_CHANNELS; c++) {
+        color.c[c] = (PWM_TABLES.level8Fine[rgb[c]] * level + PWM_FINE_MAX / 2) / PWM_FINE_MAX;
+    }
+    return color;
+}
+
+inline LinearColor fromColor8(uint8_t red, uint8_t green, uint8_t blue) {
+    const uint8_t rgb[COLOR_CHANNELS] = {red, green, blue};
+    return fromColor8(rgb);
+}
+
+// Color temperature at a linear level (0..PWM_FINE_MAX)
+inline LinearColor fromKelvin(uint32_t kelvin, int duv, int level) {
+    LinearColor color;
+    cct::render(kelvin, duv, level, color.c);
+    return color;
+}
+
+inline LinearColor fromState(const ColorState& state) {
+    if (state.kelvin != 0) {
+        return fromKelvin(state.kelvin, 0, PWM_TABLES.level8Fine[state.brightness]);
+    }
+    return fromColor8(state.rgb, state.brightness);
+}
+
+// Linear 11-bit duties (knobs, blink patterns)
+inline LinearColor fromDuty(int red, int green, int blue) {
+    LinearColor color;
+    color.c[0] = clampDuty(red) << DITHER_BITS;
+    color.c[1] = clampDuty(green) << DITHER_BITS;
+    color.c[2] = clampDuty(blue) << DITHER_BITS;
+    return color;
+}
+
+}  // namespace color_source
+
+// Stages
+
+struct ColorCorrection {
+    static inline void apply(LinearColor& color) {
+        if constexpr (!pipeline_detail::CORRECTION.identity) {
+            LinearColor in = color;
+            for (int row = 0; row < COLOR_CHANNELS; row++) {
+                int sum = 0;
+                for (int col = 0; col < COLOR_CHANNELS; col++) {
+                    sum += pipeline_detail::CORRECTION.m[row][col] * in.c[col];
+                }
+                color.c[row] = sum >> pipeline_detail::CORRECTION_SHIFT;
+            }
+        }
+    }
+};
+
+// Takes 0..PWM_FINE_MAX: the Q15 multiply overflows int32 above 65535, so
+// it has to run after ClampFine
+struct ChannelTrim {
+    static inline void apply(LinearColor& color) {
+        for (int c = 0; c < COLOR_CHANNELS; c++) {
+            color.c[c] = trimFine(c, color.c[c]);
+        }
+    }
+};
+
+// Correction can leave the gamut; the output takes 0..PWM_FINE_MAX
+struct ClampFine {
+    static inline void apply(LinearColor& color) {
+        for (int c = 0; c < COLOR_CHANNELS; c++) {
+            color.c[c] = color.c[c] < 0 ? 0 : (color.c[c] > PWM_FINE_MAX ? PWM_FINE_MAX : color.c[c]);
+        }
+    }
+};
+
+// Runs Stages left to right; the result is trimmed fine duties ready for
+// LEDController::writeDutiesFine()
+template <typename... Stages>
+struct ColorPipeline {
+    static inline LinearColor run(LinearColor color) {
+        (Stages::apply(color), ...);
+        return color;
+    }
+};
+
+using LampPipeline = ColorPipeline<ColorCorrection, ClampFine, ChannelTrim>;
+
+#endif
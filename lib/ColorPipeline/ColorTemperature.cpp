@@ -0,0 +1,52 @@
+#include "ColorTemperature.h"
+
+namespace {
+
+// Nearest 8-bit level whose gamma-expanded fine level is at least fine
+uint8_t encode8(int fine) {
+    int low = 0;
+    int high = 255;
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (PWM_TABLES.level8Fine[mid] < fine) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return static_cast<uint8_t>(low);
+}
+
+}  // namespace
+
+namespace cct {
+
+uint16_t kelvinToMireds(uint32_t kelvin) {
+    kelvin = clampKelvin(kelvin);
+    return static_cast<uint16_t>((1000000u + kelvin / 2) / kelvin);
+}
+
+uint32_t miredsToKelvin(uint32_t mireds) {
+    if (mireds == 0) {
+        return CCT_MAX_K;
+    }
+    return clampKelvin((1000000u + mireds / 2) / mireds);
+}
+
+void renderFloat(float kelvin, float duv, float level, int fine[COLOR_CHANNELS]) {
+    cct_detail::Rgb rgb = cct_detail::normalise(
+        cct_detail::planckianLinear(clampKelvin(static_cast<uint32_t>(kelvin)), duv / 10000.0f));
+    for (int c = 0; c < COLOR_CHANNELS; c++) {
+        fine[c] = static_cast<int>(rgb.c[c] * level);
+    }
+}
+
+void toColor8(uint32_t kelvin, int duv, uint8_t brightness, uint8_t rgb[COLOR_CHANNELS]) {
+    int fine[COLOR_CHANNELS];
+    render(kelvin, duv, PWM_TABLES.level8Fine[brightness], fine);
+    for (int c = 0; c < COLOR_CHANNELS; c++) {
+        rgb[c] = encode8(fine[c]);
+    }
+}
+
+}  // namespace cct
@@ -0,0 +1,255 @@
+#ifndef COLOR_TEMPERATURE_H
+#define COLOR_TEMPERATURE_H
+
+#include <stdint.h>
+#include "PwmTables.h"
+
+// Correlated color temperature range, in Kelvin: one table entry every
+// 128 K, so the lookup is a shift and a mask. Home Assistant gets the same
+// range as mireds (153..556).
+static constexpr int CCT_STEP_SHIFT = 7;
+static constexpr int CCT_STEP_K = 1 << CCT_STEP_SHIFT;
+static constexpr int CCT_ENTRIES = 38;
+static constexpr int CCT_MIN_K = 1800;
+static constexpr int CCT_MAX_K = CCT_MIN_K + (CCT_ENTRIES - 1) * CCT_STEP_K;   // 6536 K
+
+// Tint as Duv in units of 1e-4: +256 is 0.0256 above the locus (greener),
+// -256 below it (pinker). A power of two for the same reason.
+static constexpr int DUV_SHIFT = 8;
+static constexpr int DUV_LIMIT = 1 << DUV_SHIFT;
+
+static constexpr int CCT_ONE = 1 << 15;   // Q15 full scale of the table
+
+namespace cct_detail {
+
+// Newton's method after scaling x into [0.25, 1); x > 0
+constexpr double sqrt(double x) {
+    double scale = 1.0;
+    while (x >= 1.0) { x *= 0.25; scale *= 2.0; }
+    while (x < 0.25) { x *= 4.0; scale *= 0.5; }
+    double r = 0.75;
+    for (int i = 0; i < 5; i++) {
+        r = 0.5 * (r + x / r);
+    }
+    return r * scale;
+}
+
+// Planckian locus in CIE 1931 xy, cubic spline fit of Kim et al. (2002),
+// valid 1667-25000 K
+constexpr double locusX(double t) {
+    return t <= 4000.0
+        ? -0.2661239e9 / (t * t * t) - 0.2343589e6 / (t * t) + 0.8776956e3 / t + 0.179910
+        : -3.0258469e9 / (t * t * t) + 2.1070379e6 / (t * t) + 0.2226347e3 / t + 0.240390;
+}
+
+constexpr double locusY(double t) {
+    double x = locusX(t);
+    return t <= 2222.0 ? -1.1063814 * x * x * x - 1.34811020 * x * x + 2.18555832 * x - 0.20219683
+         : t <= 4000.0 ? -0.9549476 * x * x * x - 1.37418593 * x * x + 2.09137015 * x - 0.16748867
+                       : 3.0817580 * x * x * x - 5.87338670 * x * x + 3.75112997 * x - 0.37001483;
+}
+
+// CIE 1960 uv, where Duv is measured
+constexpr double toU(double x, double y) { return 4.0 * x / (-2.0 * x + 12.0 * y + 3.0); }
+constexpr double toV(double x, double y) { return 6.0 * y / (-2.0 * x + 12.0 * y + 3.0); }
+
+struct Rgb {
+    double c[COLOR_CHANNELS];
+};
+
+// Linear sRGB for a uv point at Y = 1; channels go slightly negative just
+// outside sRGB at the warm end
+constexpr Rgb uvToLinear(double u, double v) {
+    double d = 2.0 * u - 8.0 * v + 4.0;
+    double x = 3.0 * u / d;
+    double y = 2.0 * v / d;
+    double bigX = x / y;
+    double bigZ = (1.0 - x - y) / y;
+    return {{
+        3.2404542 * bigX - 1.5371385 - 0.4985314 * bigZ,
+        -0.9692660 * bigX + 1.8760108 + 0.0415560 * bigZ,
+        0.0556434 * bigX - 0.2040259 + 1.0572252 * bigZ,
+    }};
+}
+
+// Linear RGB of the point duv (absolute, e.g. 0.01) off the locus at t K
+constexpr Rgb planckianLinear(double t, double duv) {
+    double u = toU(locusX(t), locusY(t));
+    double v = toV(locusX(t), locusY(t));
+
+    // Unit normal to the locus in uv, pointing to +v (green). The tangent
+    // steps back at the fit's segment ends so it never spans two segments.
+    double step = (t <= 2222.0 && t + 1.0 > 2222.0) || (t <= 4000.0 && t + 1.0 > 4000.0) ? -1.0 : 1.0;
+    double du = toU(locusX(t + step), locusY(t + step)) - u;
+    double dv = toV(locusX(t + step), locusY(t + step)) - v;
+    double length = sqrt(du * du + dv * dv);
+    double nu = -dv / length;
+    double nv = du / length;
+    if (nv < 0.0) {
+        nu = -nu;
+        nv = -nv;
+    }
+    return uvToLinear(u + nu * duv, v + nv * duv);
+}
+
+// Clipped to the gamut and scaled so the largest channel is 1 (constant
+// peak, so every temperature can reach full output)
+constexpr Rgb normalise(Rgb rgb) {
+    double peak = 0.0;
+    for (int c = 0; c < COLOR_CHANNELS; c++) {
+        rgb.c[c] = rgb.c[c] < 0.0 ? 0.0 : rgb.c[c];
+        peak = rgb.c[c] > peak ? rgb.c[c] : peak;
+    }
+    for (int c = 0; c < COLOR_CHANNELS; c++) {
+        rgb.c[c] /= peak;
+    }
+    return rgb;
+}
+
+}  // namespace cct_detail
+
+// Linear RGB at Y = 1 (Q13, so the reddest 1800 K point still fits) on a
+// grid generated at compile time: every CCT_STEP_K along the locus, and
+// every DUV_ROW_STEP across it from -DUV_LIMIT (row 0, pinker) to
+// +DUV_LIMIT (greener). Stored before clipping and normalising: both bend
+// where the peak channel changes, and interpolating across such a bend is
+// off by percents. Runtime is a bilinear lookup (three integer lerps per
+// channel), then a clip and one divide to normalise; 1 KB of flash.
+static constexpr int CCT_TABLE_SHIFT = 13;
+static constexpr int DUV_ROW_SHIFT = 7;
+static constexpr int DUV_ROW_STEP = 1 << DUV_ROW_SHIFT;
+static constexpr int DUV_ROWS = 2 * DUV_LIMIT / DUV_ROW_STEP + 1;
+static constexpr int DUV_LOCUS_ROW = DUV_LIMIT / DUV_ROW_STEP;
+
+struct PlanckianTable {
+    int16_t grid[DUV_ROWS][CCT_ENTRIES][COLOR_CHANNELS] = {};
+    double largest = 0.0;   // For the range check below
+
+    constexpr PlanckianTable() {
+        for (int row = 0; row < DUV_ROWS; row++) {
+            for (int i = 0; i < CCT_ENTRIES; i++) {
+                double duv = (row - DUV_LOCUS_ROW) * DUV_ROW_STEP / 10000.0;
+                cct_detail::Rgb rgb = cct_detail::planckianLinear(CCT_MIN_K + i * CCT_STEP_K, duv);
+                for (int c = 0; c < COLOR_CHANNELS; c++) {
+                    double scaled = rgb.c[c] * (1 << CCT_TABLE_SHIFT);
+                    largest = scaled > largest ? scaled : (-scaled > largest ? -scaled : largest);
+                    grid[row][i][c] = static_cast<int16_t>(scaled < 0.0 ? scaled - 0.5 : scaled + 0.5);
+                }
+            }
+        }
+    }
+};
+
+inline constexpr PlanckianTable PLANCKIAN{};
+
+static_assert(PLANCKIAN.largest < 32767.0, "Planckian table fits int16");
+// Warm light is red-heavy, the cool end near white, positive Duv greener
+static_assert(PLANCKIAN.grid[DUV_LOCUS_ROW][0][0] > 2 * PLANCKIAN.grid[DUV_LOCUS_ROW][0][1] &&
+              PLANCKIAN.grid[DUV_LOCUS_ROW][0][2] < 0, "1800 K is red-heavy");
+static_assert(PLANCKIAN.grid[DUV_LOCUS_ROW][CCT_ENTRIES - 1][0] - PLANCKIAN.grid[DUV_LOCUS_ROW][CCT_ENTRIES - 1][2] < 1000,
+              "the cool end is near white");
+static_assert(PLANCKIAN.grid[DUV_ROWS - 1][20][1] > PLANCKIAN.grid[DUV_LOCUS_ROW][20][1], "positive Duv is greener");
+
+// Temperature knob to Kelvin every 32 counts, linear in mireds so equal
+// turns are roughly equal perceived steps; interpolated instead of divided
+static constexpr int KNOB_KELVIN_SHIFT = 5;
+static constexpr int KNOB_KELVIN_ENTRIES = (PWM_LEVELS >> KNOB_KELVIN_SHIFT) + 1;
+
+struct KnobKelvinTable {
+    uint16_t kelvin[KNOB_KELVIN_ENTRIES] = {};
+
+    constexpr KnobKelvinTable() {
+        double warm = 1e6 / CCT_MIN_K;
+        double cool = 1e6 / CCT_MAX_K;
+        for (int i = 0; i < KNOB_KELVIN_ENTRIES; i++) {
+            double mireds = warm - (warm - cool) * i / (KNOB_KELVIN_ENTRIES - 1);
+            kelvin[i] = static_cast<uint16_t>(1e6 / mireds + 0.5);
+        }
+    }
+};
+
+inline constexpr KnobKelvinTable KNOB_KELVIN{};
+static_assert(KNOB_KELVIN.kelvin[0] == CCT_MIN_K && KNOB_KELVIN.kelvin[KNOB_KELVIN_ENTRIES - 1] == CCT_MAX_K,
+              "knob spans the table");
+
+// Tint knob: this many counts either side of centre stay on the locus
+static constexpr int TINT_DETENT = 24;
+
+namespace cct {
+
+inline uint32_t clampKelvin(uint32_t kelvin) {
+    return kelvin < CCT_MIN_K ? CCT_MIN_K : (kelvin > CCT_MAX_K ? CCT_MAX_K : kelvin);
+}
+
+uint16_t kelvinToMireds(uint32_t kelvin);
+uint32_t miredsToKelvin(uint32_t mireds);
+
+// Untrimmed linear fine duties for a temperature, tint and level
+// (0..PWM_FINE_MAX, the output of the peak channel). Inline: this is the
+// whole per-update cost of the knob path.
+inline void render(uint32_t kelvin, int duv, int level, int fine[COLOR_CHANNELS]) {
+    uint32_t offset = clampKelvin(kelvin) - CCT_MIN_K;
+    int index = offset >> CCT_STEP_SHIFT;
+    int along = (offset & (CCT_STEP_K - 1)) << (15 - CCT_STEP_SHIFT);
+    if (index >= CCT_ENTRIES - 1) {
+        index = CCT_ENTRIES - 2;
+        along = CCT_ONE;
+    }
+
+    int shifted = duv + DUV_LIMIT;
+    shifted = shifted < 0 ? 0 : (shifted > 2 * DUV_LIMIT ? 2 * DUV_LIMIT : shifted);
+    int row = shifted >> DUV_ROW_SHIFT;
+    int across = (shifted & (DUV_ROW_STEP - 1)) << (15 - DUV_ROW_SHIFT);
+    if (row >= DUV_ROWS - 1) {
+        row = DUV_ROWS - 2;
+        across = CCT_ONE;
+    }
+    const int16_t (*low)[COLOR_CHANNELS] = PLANCKIAN.grid[row];
+    const int16_t (*high)[COLOR_CHANNELS] = PLANCKIAN.grid[row + 1];
+    level = level < 0 ? 0 : (level > PWM_FINE_MAX ? PWM_FINE_MAX : level);
+
+    int linear[COLOR_CHANNELS];
+    int peak = 1;
+    for (int c = 0; c < COLOR_CHANNELS; c++) {
+        int below = low[index][c];
+        below += ((low[index + 1][c] - below) * along) >> 15;
+        int above = high[index][c];
+        above += ((high[index + 1][c] - above) * along) >> 15;
+        int value = below + (((above - below) * across) >> 15);
+        linear[c] = value < 0 ? 0 : value;
+        peak = linear[c] > peak ? linear[c] : peak;
+    }
+    // linear <= peak, so linear * scale stays within level << 15
+    int scale = (level << 15) / peak;
+    for (int c = 0; c < COLOR_CHANNELS; c++) {
+        fine[c] = (linear[c] * scale) >> 15;
+    }
+}
+
+// The same color computed in floating point at runtime, from the spline and
+// matrix the table is built from; reference for the benchmark suite and
+// the table check in the simulator
+void renderFloat(float kelvin, float duv, float level, int fine[COLOR_CHANNELS]);
+
+// The same at an 8-bit brightness, as gamma-encoded 8-bit RGB - the color
+// Home Assistant and the effects engine work with
+void toColor8(uint32_t kelvin, int duv, uint8_t brightness, uint8_t rgb[COLOR_CHANNELS]);
+
+// Knob (0..PWM_MAX) mappings; knob fully left is warm, as with the old
+// temperature mix, and the tint is centred on the locus
+inline uint32_t knobToKelvin(int knob) {
+    knob = clampDuty(knob);
+    int low = KNOB_KELVIN.kelvin[knob >> KNOB_KELVIN_SHIFT];
+    int high = KNOB_KELVIN.kelvin[(knob >> KNOB_KELVIN_SHIFT) + 1];
+    return low + (((high - low) * (knob & ((1 << KNOB_KELVIN_SHIFT) - 1))) >> KNOB_KELVIN_SHIFT);
+}
+
+inline int knobToDuv(int knob) {
+    int offset = clampDuty(knob) - PWM_LEVELS / 2;
+    int outside = offset > TINT_DETENT ? offset - TINT_DETENT : (offset < -TINT_DETENT ? offset + TINT_DETENT : 0);
+    return outside * DUV_LIMIT / (PWM_LEVELS / 2 - TINT_DETENT);
+}
+
+}  // namespace cct
+
+#endif
@@ -0,0 +1,247 @@
+#include "EffectsEngine.h"
+#include <string.h>
+#include "Log.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <esp_timer.h>
+static inline uint32_t renderClockUs() { return static_cast<uint32_t>(esp_timer_get_time()); }
+#else
+#include <chrono>
+static inline uint32_t renderClockUs() {
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+#endif
+
+namespace {
+
+const char* const EFFECT_NAMES[EffectsEngine::EFFECT_COUNT] = {
+    "none", "breathe", "color_cycle", "candle", "rainbow"
+};
+
+constexpr uint32_t BREATHE_CYCLE_MS = 4000;
+constexpr uint32_t RAINBOW_CYCLE_MS = 6000;
+
+// Red -> green -> blue with a short hold on each primary
+const EffectKeyframe COLOR_CYCLE_FRAMES[] = {
+    {0, {255, 0, 0}},
+    {1000, {255, 0, 0}},
+    {4000, {0, 255, 0}},
+    {5000, {0, 255, 0}},
+    {8000, {0, 0, 255}},
+    {9000, {0, 0, 255}},
+};
+constexpr uint32_t COLOR_CYCLE_MS = 12000;  // Last frame fades back to the first
+
+// Raised cosine, 0..32767 over one period, for the breathe effect
+struct BreatheTable {
+    uint16_t level[256] = {};
+
+    constexpr BreatheTable() {
+        for (int i = 0; i < 256; i++) {
+            double x = 2.0 * 3.14159265358979 * i / 256.0;
+            // cos(x) by Taylor series after folding into [-pi, pi]
+            if (x > 3.14159265358979) {
+                x -= 2.0 * 3.14159265358979;
+            }
+            double term = 1.0;
+            double cosine = 1.0;
+            for (int k = 1; k < 20; k++) {
+                term *= -x * x / ((2 * k - 1) * (2 * k));
+                cosine += term;
+            }
+            level[i] = static_cast<uint16_t>((1.0 - cosine) * 0.5 * 32767.0 + 0.5);
+        }
+    }
+};
+
+constexpr BreatheTable BREATHE{};
+
+}  // namespace
+
+const char* EffectsEngine::effectName(Effect effect) {
+    uint8_t index = static_cast<uint8_t>(effect);
+    return index < EFFECT_COUNT ? EFFECT_NAMES[index] : EFFECT_NAMES[0];
+}
+
+bool EffectsEngine::effectFromName(const char* name, Effect& effect) {
+    for (int i = 0; i < EFFECT_COUNT; i++) {
+        if (strcmp(name, EFFECT_NAMES[i]) == 0) {
+            effect = static_cast<Effect>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+void EffectsEngine::setEffect(Effect newEffect, uint32_t nowMs) {
+    effectStartMs.store(nowMs);
+    effect.store(static_cast<uint8_t>(newEffect));
+    // Published last: a task that sees the new generation sees the effect
+    generation.store(generation.load() + 1);
+}
+
+void EffectsEngine::stop() {
+    effect.store(static_cast<uint8_t>(Effect::NONE));
+    generation.store(generation.load() + 1);
+}
+
+void EffectsEngine::setBaseColor(uint8_t red, uint8_t green, uint8_t blue, uint8_t brightness) {
+    baseColor.store((static_cast<uint32_t>(brightness) << 24) | (static_cast<uint32_t>(red) << 16) |
+                    (static_cast<uint32_t>(green) << 8) | blue);
+}
+
+int EffectsEngine::renderKeyframes(const EffectKeyframe* frames, int count, uint32_t cycleMs,
+                                   uint32_t elapsedMs, LinearColor& color) const {
+    uint32_t t = elapsedMs % cycleMs;
+    int index = count - 1;
+    while (index > 0 && frames[index].timeMs > t) {
+        index--;
+    }
+    const EffectKeyframe& a = frames[index];
+    const EffectKeyframe& b = frames[(index + 1) % count];
+    uint32_t span = (index + 1 < count ? b.timeMs : cycleMs) - a.timeMs;
+    int32_t progress = span ? static_cast<int32_t>(((t - a.timeMs) << 16) / span) : 0;
+
+    for (int c = 0; c < COLOR_CHANNELS; c++) {
+        int from = PWM_TABLES.level8Fine[a.color[c]];
+        int to = PWM_TABLES.level8Fine[b.color[c]];
+        color.c[c] = from + static_cast<int>((static_cast<int64_t>(to - from) * progress) >> 16);
+    }
+    return index;
+}
+
+// keepHue: multiply by the base color (breathe/candle keep the HA color);
+// otherwise only scale by its brightness (cycle/rainbow pick their own hue)
+void EffectsEngine::scaleByBase(LinearColor& color, bool keepHue) const {
+    uint32_t packed = baseColor.load();
+    uint8_t base[COLOR_CHANNELS] = {
+        static_cast<uint8_t>(packed >> 16), static_cast<uint8_t>(packed >> 8), static_cast<uint8_t>(packed)
+    };
+    int brightness = PWM_TABLES.level8Fine[packed >> 24];
+
+    for (int c = 0; c < COLOR_CHANNELS; c++) {
+        int scale = keepHue ? (PWM_TABLES.level8Fine[base[c]] * brightness) / PWM_FINE_MAX : brightness;
+        color.c[c] = (color.c[c] * scale) / PWM_FINE_MAX;
+    }
+}
+
+bool EffectsEngine::render(uint32_t nowMs, LinearColor& color) {
+    uint32_t elapsed = nowMs - effectStartMs.load();
+
+    switch (getEffect()) {
+    case Effect::BREATHE: {
+        // Floor at ~6% so the lamp never fully goes dark mid-breath
+        uint32_t phase = ((elapsed % BREATHE_CYCLE_MS) << 8) / BREATHE_CYCLE_MS;
+        int level = 2048 + ((BREATHE.level[phase] * (32767 - 2048)) >> 15);
+        for (int c = 0; c < COLOR_CHANNELS; c++) {
+            color.c[c] = (PWM_FINE_MAX * level) >> 15;
+        }
+        scaleByBase(color, true);
+        return true;
+    }
+    case Effect::COLOR_CYCLE:
+        renderKeyframes(COLOR_CYCLE_FRAMES, sizeof(COLOR_CYCLE_FRAMES) / sizeof(COLOR_CYCLE_FRAMES[0]),
+                        COLOR_CYCLE_MS, elapsed, color);
+        scaleByBase(color, false);
+        return true;
+    case Effect::CANDLE: {
+        // xorshift32 noise, low-passed, with an occasional deeper gutter
+        candleSeed ^= candleSeed << 13;
+        candleSeed ^= candleSeed >> 17;
+        candleSeed ^= candleSeed << 5;
+        int target = PWM_MAX - static_cast<int>(candleSeed % 512);
+        if ((candleSeed >> 24) < 6) {
+            target -= 700;
+        }
+        int level = clampDuty(candleLevel.update(target)) << DITHER_BITS;
+        // Warm, slightly orange flame tinted by the base color
+        color.c[0] = level;
+        color.c[1] = (level * 11) >> 4;
+        color.c[2] = level >> 4;
+        scaleByBase(color, true);
+        return true;
+    }
+    case Effect::RAINBOW: {
+        // Integer HSV wheel, full saturation: 6 sectors of 256 steps
+        uint32_t hue = ((elapsed % RAINBOW_CYCLE_MS) * 1536) / RAINBOW_CYCLE_MS;
+        int rising = static_cast<int>(hue & 0xFF);
+        int falling = 255 - rising;
+        uint8_t rgb[COLOR_CHANNELS];
+        switch (hue >> 8) {
+        case 0: rgb[0] = 255; rgb[1] = rising; rgb[2] = 0; break;
+        case 1: rgb[0] = falling; rgb[1] = 255; rgb[2] = 0; break;
+        case 2: rgb[0] = 0; rgb[1] = 255; rgb[2] = rising; break;
+        case 3: rgb[0] = 0; rgb[1] = falling; rgb[2] = 255; break;
+        case 4: rgb[0] = rising; rgb[1] = 0; rgb[2] = 255; break;
+        default: rgb[0] = 255; rgb[1] = 0; rgb[2] = falling; break;
+        }
+        for (int c = 0; c < COLOR_CHANNELS; c++) {
+            color.c[c] = PWM_TABLES.level8Fine[rgb[c]];
+        }
+        scaleByBase(color, false);
+        return true;
+    }
+    case Effect::NONE:
+    default:
+        return false;
+    }
+}
+
+void EffectsEngine::renderFrame(uint32_t nowMs) {
+    uint32_t start = renderClockUs();
+    EffectFrame frame;
+    frame.generation = generation.load();
+    if (frame.generation != renderedGeneration) {
+        // A new selection starts its own candle flicker
+        renderedGeneration = frame.generation;
+        candleLevel.reset(PWM_MAX);
+    }
+    if (!render(nowMs, frame.color)) {
+        return;
+    }
+    frames.store(frame);
+    uint32_t renderUs = renderClockUs() - start;
+
+    stats.frames++;
+    stats.lastRenderUs = renderUs;
+    stats.totalRenderUs += renderUs;
+    if (renderUs > stats.maxRenderUs) {
+        stats.maxRenderUs = renderUs;
+    }
+    if (renderUs > FRAME_MS * 1000) {
+        stats.lateFrames++;
+    }
+}
+
+bool EffectsEngine::applyFrame() {
+    EffectFrame frame;
+    if (!frames.take(frame) || frame.generation != generation.load() || !isActive()) {
+        return false;
+    }
+    ledController.show(frame.color);
+    return true;
+}
+
+#ifdef ARDUINO
+
+bool EffectsEngine::begin(int priority) {
+    if (xTaskCreate(renderTask, "effects", 3072, this, priority,
+                    reinterpret_cast<TaskHandle_t*>(&taskHandle)) != pdPASS) {
+        LOG_E("EffectsEngine: failed to create render task");
+        return false;
+    }
+    return true;
+}
+
+void EffectsEngine::renderTask(void* arg) {
+    EffectsEngine* self = static_cast<EffectsEngine*>(arg);
+    TickType_t lastWake = xTaskGetTickCount();
+    for (;;) {
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(FRAME_MS));
+        self->renderFrame(millis());
+    }
+}
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef EFFECTS_ENGINE_H
+#define EFFECTS_ENGINE_H
+
+#include <stdint.h>
+#include <atomic>
+#include "LEDController.h"
+#include "Filters.h"
+#include "LatestSlot.h"
+
+enum class Effect : uint8_t {
+    NONE,
+    BREATHE,
+    COLOR_CYCLE,
+    CANDLE,
+    RAINBOW,
+};
+
+struct EffectKeyframe {
+    uint16_t timeMs;           // Offset from the start of the cycle
+    uint8_t color[COLOR_CHANNELS];
+};
+
+struct EffectStats {
+    uint32_t frames = 0;
+    uint32_t lastRenderUs = 0;
+    uint32_t maxRenderUs = 0;
+    uint32_t totalRenderUs = 0;  // For the average, wraps after ~70 min at 100 Hz
+    uint32_t lateFrames = 0;     // Render took longer than a frame
+};
+
+// A rendered frame, tagged with the effect selection it was rendered for
+struct EffectFrame {
+    LinearColor color;
+    uint32_t generation = 0;
+};
+
+// Animated effects rendered from integer keyframes and wave tables. On the
+// ESP32 a dedicated FreeRTOS task renders at FRAME_RATE_HZ into a one-frame
+// mailbox, and the control loop writes the newest frame with applyFrame(),
+// so the LEDs have a single writer. Everything the task reads from other
+// tasks (effect, base color, generation) is atomic.
+//
+// setEffect() and stop() bump a generation counter; a frame rendered for an
+// earlier selection carries the old one and is dropped, so stopping needs
+// no handshake with the task.
+//
+// render() is pure and can be driven from host builds with any timeline.
+class EffectsEngine {
+public:
+    static constexpr uint32_t FRAME_RATE_HZ = 100;
+    static constexpr uint32_t FRAME_MS = 1000 / FRAME_RATE_HZ;
+    static constexpr int EFFECT_COUNT = 5;
+
+private:
+    LEDController& ledController;
+    std::atomic<uint8_t> effect{static_cast<uint8_t>(Effect::NONE)};
+    std::atomic<uint32_t> baseColor{0xFFFFFFFF};  // Brightness and 8-bit RGB packed 0xLLRRGGBB
+    std::atomic<uint32_t> effectStartMs{0};
+    std::atomic<uint32_t> generation{0};   // Written by the control loop only
+    uint32_t renderedGeneration = 0;       // Render task only
+    LatestSlot<EffectFrame> frames;        // Render task -> control loop
+    uint32_t candleSeed = 0x2545F491;
+    ExponentialAverage<3> candleLevel;
+    EffectStats stats;
+
+#ifdef ARDUINO
+    void* taskHandle = nullptr;
+    static void renderTask(void* arg);
+#endif
+
+    int renderKeyframes(const EffectKeyframe* frames, int count, uint32_t cycleMs,
+                        uint32_t elapsedMs, LinearColor& color) const;
+    void scaleByBase(LinearColor& color, bool keepHue) const;
+
+public:
+    explicit EffectsEngine(LEDController& controller) : ledController(controller) {}
+
+#ifdef ARDUINO
+    // Starts the render task. priority should sit above the control loop's
+    // (2) so frames are rendered on time; a frame costs a few microseconds.
+    bool begin(int priority = 3);
+#endif
+
+    void setEffect(Effect newEffect, uint32_t nowMs);
+    Effect getEffect() const { return static_cast<Effect>(effect.load()); }
+    bool isActive() const { return getEffect() != Effect::NONE; }
+    // No frame rendered before this call is applied afterwards, so the
+    // caller can take over the LEDs straight away
+    void stop();
+
+    // Color the effects are tinted by and brightness they are scaled by
+    // (the last HA color, at full brightness, and its brightness)
+    void setBaseColor(uint8_t red, uint8_t green, uint8_t blue, uint8_t brightness);
+
+    // Computes the linear color (a pipeline source) for the current effect
+    // at nowMs. Returns false if no effect is active.
+    bool render(uint32_t nowMs, LinearColor& color);
+
+    // Render one frame into the mailbox; used by the task, callable from a
+    // host loop.
+    void renderFrame(uint32_t nowMs);
+
+    // Control loop: writes the newest frame, if it belongs to the current
+    // selection. Returns true if the LEDs were written.
+    bool applyFrame();
+
+    const EffectStats& getStats() const { return stats; }
+
+    // Names as published in the Home Assistant effect_list
+    static const char* effectName(Effect effect);
+    static bool effectFromName(const char* name, Effect& effect);
+};
+
+#endif
@@ -0,0 +1,43 @@
+#include "FadeEngine.h"
+
+void FadeEngine::fadeTo(const LinearColor& color, uint32_t duration, uint32_t nowMs) {
+    LinearColor duty = LampPipeline::run(color);
+    fadeToFine(duty.c[0], duty.c[1], duty.c[2], duration, nowMs);
+}
+
+void FadeEngine::fadeToFine(int red, int green, int blue, uint32_t duration, uint32_t nowMs) {
+    ledController.getFineValues(from[0], from[1], from[2]);
+    to[0] = red;
+    to[1] = green;
+    to[2] = blue;
+    startMs = nowMs;
+    durationMs = duration;
+
+    if (duration == 0) {
+        active = false;
+        ledController.writeDutiesFine(to[0], to[1], to[2]);
+        return;
+    }
+    active = true;
+}
+
+bool FadeEngine::update(uint32_t nowMs) {
+    if (!active) {
+        return false;
+    }
+
+    uint32_t elapsed = nowMs - startMs;
+    if (elapsed >= durationMs) {
+        active = false;
+        ledController.writeDutiesFine(to[0], to[1], to[2]);
+        return false;
+    }
+
+    int32_t progress = static_cast<int32_t>((static_cast<uint64_t>(elapsed) << 16) / durationMs);
+    int duty[COLOR_CHANNELS];
+    for (int c = 0; c < COLOR_CHANNELS; c++) {
+        duty[c] = from[c] + static_cast<int>((static_cast<int64_t>(to[c] - from[c]) * progress) >> 16);
+    }
+    ledController.writeDutiesFine(duty[0], duty[1], duty[2]);
+    return true;
+}
@@ -0,0 +1,42 @@
+#ifndef FADE_ENGINE_H
+#define FADE_ENGINE_H
+
+#include <stdint.h>
+#include "LEDController.h"
+
+// Non-blocking color fades. fadeTo() only records a start point, target and
+// duration; update() is called from a fixed-rate scheduler group and writes
+// the interpolated duty for the current time. Interpolation runs on trimmed
+// fine duties (linear light, 11 bits plus the dither fraction), with Q16
+// progress so there is no float math per step; slow fades at the bottom of
+// the range get 16x the steps an 11-bit fade would. Calling fadeTo()
+// mid-fade retargets from whatever is currently on the LEDs, so a new Home
+// Assistant command never jumps.
+class FadeEngine {
+private:
+    LEDController& ledController;
+    int from[COLOR_CHANNELS] = {0};
+    int to[COLOR_CHANNELS] = {0};
+    uint32_t startMs = 0;
+    uint32_t durationMs = 0;
+    bool active = false;
+
+public:
+    explicit FadeEngine(LEDController& controller) : ledController(controller) {}
+
+    // Fade to a source color; it goes through LampPipeline once, here, and
+    // the fade runs on the result. A zero duration writes it immediately.
+    void fadeTo(const LinearColor& color, uint32_t durationMs, uint32_t nowMs);
+
+    // Fade to trimmed fine duties (as returned by getFineValues()).
+    void fadeToFine(int red, int green, int blue, uint32_t durationMs, uint32_t nowMs);
+
+    // Advance the active fade. Returns true while a fade is still running.
+    bool update(uint32_t nowMs);
+
+    // Stop where we are (e.g. another mode takes over the LEDs).
+    void cancel() { active = false; }
+    bool isActive() const { return active; }
+};
+
+#endif
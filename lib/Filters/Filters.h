@@ -0,0 +1,192 @@
+#ifndef FILTERS_H
+#define FILTERS_H
+
+#include <stdint.h>
+
+// Streaming integer filters for the pot path. Every filter has a fixed-size
+// state decided at compile time, does constant work per sample and shares
+// the same interface:
+//
+//   int update(int sample);   // push a sample, return the filtered value
+//   int value() const;        // last filtered value
+//   void reset(int value);    // jump straight to a value (no ramp)
+//
+// so they can be swapped in FilterBank without touching the callers.
+
+// Boxcar average over the last N samples, kept as a running sum.
+template <int N>
+class MovingAverage {
+    static_assert(N > 0, "MovingAverage window must be positive");
+
+private:
+    int32_t window[N] = {0};
+    int32_t sum = 0;
+    int index = 0;
+
+public:
+    int update(int sample) {
+        sum += sample - window[index];
+        window[index] = sample;
+        index = (index + 1 == N) ? 0 : index + 1;
+        return value();
+    }
+
+    int value() const { return static_cast<int>(sum / N); }
+
+    void reset(int v) {
+        for (int i = 0; i < N; i++) {
+            window[i] = v;
+        }
+        sum = static_cast<int32_t>(v) * N;
+        index = 0;
+    }
+};
+
+// Single-pole low-pass: y += (x - y) / 2^SHIFT. The state carries FRAC_BITS
+// extra bits of precision so small steps are not lost to truncation.
+template <int SHIFT, int FRAC_BITS = 8>
+class ExponentialAverage {
+    static_assert(SHIFT > 0 && SHIFT < 16, "ExponentialAverage shift out of range");
+
+private:
+    int32_t state = 0;
+
+public:
+    int update(int sample) {
+        state += ((static_cast<int32_t>(sample) << FRAC_BITS) - state) >> SHIFT;
+        return value();
+    }
+
+    int value() const { return static_cast<int>((state + (1 << (FRAC_BITS - 1))) >> FRAC_BITS); }
+
+    void reset(int v) { state = static_cast<int32_t>(v) << FRAC_BITS; }
+};
+
+// Running median of the last N samples. A sorted copy of the window is kept
+// alongside it, so each sample costs one removal and one insertion into an
+// N-element array - fine for the small odd windows used for spike rejection.
+template <int N>
+class MedianFilter {
+    static_assert(N > 0 && (N % 2) == 1, "MedianFilter window must be odd");
+
+private:
+    int32_t window[N] = {0};
+    int32_t sorted[N] = {0};
+    int index = 0;
+
+public:
+    int update(int sample) {
+        int32_t oldest = window[index];
+        window[index] = sample;
+        index = (index + 1 == N) ? 0 : index + 1;
+
+        // Remove the oldest value from the sorted window...
+        int pos = 0;
+        while (sorted[pos] != oldest) {
+            pos++;
+        }
+        for (; pos < N - 1; pos++) {
+            sorted[pos] = sorted[pos + 1];
+        }
+        // ...and insert the new one
+        pos = N - 1;
+        while (pos > 0 && sorted[pos - 1] > sample) {
+            sorted[pos] = sorted[pos - 1];
+            pos--;
+        }
+        sorted[pos] = sample;
+        return value();
+    }
+
+    int value() const { return static_cast<int>(sorted[N / 2]); }
+
+    void reset(int v) {
+        for (int i = 0; i < N; i++) {
+            window[i] = v;
+            sorted[i] = v;
+        }
+        index = 0;
+    }
+};
+
+// One Euro filter (Casiez et al.): a low-pass whose cutoff rises with the
+// signal's speed, so the output is steady when the knob rests and follows
+// quickly when it moves. Parameters are integers so they can be template
+// arguments:
+//   SAMPLE_RATE_HZ  rate update() is called at
+//   MIN_CUTOFF_MHZ  cutoff at rest, in millihertz
+//   BETA_UHZ        cutoff increase per unit/s of speed, in microhertz
+//   D_CUTOFF_MHZ    cutoff of the speed estimate, in millihertz
+template <uint32_t SAMPLE_RATE_HZ, uint32_t MIN_CUTOFF_MHZ, uint32_t BETA_UHZ, uint32_t D_CUTOFF_MHZ = 1000>
+class OneEuroFilter {
+    static_assert(SAMPLE_RATE_HZ > 0, "OneEuroFilter needs a sample rate");
+
+private:
+    static constexpr int FRAC_BITS = 8;
+    static constexpr int64_t ONE_Q16 = 65536;
+
+    // 2*pi*Te scaled so that alpha_q16 = (fc_mhz * K) >> 16 gives 2*pi*fc*Te in Q16
+    static constexpr int64_t K_Q32 = static_cast<int64_t>(
+        2.0 * 3.14159265358979 * 65536.0 * 65536.0 / (1000.0 * SAMPLE_RATE_HZ) + 0.5);
+
+    static constexpr int64_t smoothingQ16(int64_t cutoffMilliHz) {
+        return (((cutoffMilliHz * K_Q32) >> 16) << 16) / (((cutoffMilliHz * K_Q32) >> 16) + ONE_Q16);
+    }
+
+    static constexpr int64_t D_ALPHA_Q16 = smoothingQ16(D_CUTOFF_MHZ);
+
+    int32_t state = 0;       // Filtered value, Q8
+    int32_t speed = 0;       // Filtered |derivative| in units/s, Q8
+    int32_t lastSample = 0;
+    bool primed = false;
+
+public:
+    int update(int sample) {
+        if (!primed) {
+            reset(sample);
+            return sample;
+        }
+
+        int32_t delta = static_cast<int32_t>(sample) - lastSample;
+        lastSample = sample;
+
+        int32_t rawSpeed = (delta < 0 ? -delta : delta) * static_cast<int32_t>(SAMPLE_RATE_HZ);
+        speed += static_cast<int32_t>((D_ALPHA_Q16 * ((static_cast<int64_t>(rawSpeed) << FRAC_BITS) - speed)) >> 16);
+
+        int64_t cutoffMilliHz = MIN_CUTOFF_MHZ + ((static_cast<int64_t>(BETA_UHZ) * (speed >> FRAC_BITS)) / 1000);
+        int64_t alpha = smoothingQ16(cutoffMilliHz);
+        state += static_cast<int32_t>((alpha * ((static_cast<int64_t>(sample) << FRAC_BITS) - state)) >> 16);
+        return value();
+    }
+
+    int value() const { return static_cast<int>((state + (1 << (FRAC_BITS - 1))) >> FRAC_BITS); }
+
+    void reset(int v) {
+        state = static_cast<int32_t>(v) << FRAC_BITS;
+        speed = 0;
+        lastSample = v;
+        primed = true;
+    }
+};
+
+// One filter instance per channel, all of the same type.
+template <typename Filter, int CHANNELS>
+class FilterBank {
+private:
+    Filter filters[CHANNELS];
+
+public:
+    int update(int channel, int sample) { return filters[channel].update(sample); }
+    int value(int channel) const { return filters[channel].value(); }
+
+    void reset(int v) {
+        for (int i = 0; i < CHANNELS; i++) {
+            filters[i].reset(v);
+        }
+    }
+
+    Filter& operator[](int channel) { return filters[channel]; }
+    const Filter& operator[](int channel) const { return filters[channel]; }
+};
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef HAL_H
+#define HAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Thin hardware layer for the control path. Everything above it (LED output,
+// mode button, power-limit storage, time) goes through these calls instead of
+// the Arduino/IDF API, so the same classes build for the ESP32 and for the
+// native host target. The backend is picked at link time: HalEsp32.cpp on
+// the device, HalNative.cpp (fakes, see HalFake.h) everywhere else. No
+// virtual calls - a PWM write is still a direct call into ledc.
+namespace hal {
+
+// Time since boot
+uint32_t nowMs();
+uint64_t nowUs();
+
+// PWM (LEDC on the ESP32). All channels share one timer, so their periods
+// line up. pwmStage() loads a duty without applying it; pwmLatch() issues
+// the updates for every staged duty in the channel mask back to back with
+// nothing preempting it. There is no group latch, so they usually land on
+// the same period boundary but can straddle one: for at most one period
+// some channels show the new duty and the rest the old. pwmWrite() is
+// stage + latch for a single channel. Setup returns false (and logs why) if
+// the driver rejected the pin, channel or timer settings.
+bool pwmSetup(int channel, uint32_t frequency, uint8_t resolutionBits);
+bool pwmAttachPin(int pin, int channel);
+void pwmWrite(int channel, uint32_t duty);
+void pwmStage(int channel, uint32_t duty);
+void pwmLatch(uint32_t channelMask);
+
+// GPIO
+void gpioInput(int pin);
+int gpioRead(int pin);
+
+// Non-volatile storage (NVS via Preferences on the ESP32). Each call opens
+// and closes the namespace, as the callers did with Preferences directly.
+bool nvsGetBool(const char* ns, const char* key, bool fallback);
+void nvsPutBool(const char* ns, const char* key, bool value);
+uint32_t nvsGetUInt(const char* ns, const char* key, uint32_t fallback);
+void nvsPutUInt(const char* ns, const char* key, uint32_t value);
+// Returns the stored length, or 0 if the key is missing or larger than size
+size_t nvsGetBytes(const char* ns, const char* key, void* data, size_t size);
+void nvsPutBytes(const char* ns, const char* key, const void* data, size_t size);
+
+// Several keys of one namespace in a single open/commit/close. Stored with
+// the same types as the single-key calls, so either can read them back.
+enum class NvsType : uint8_t {
+    BOOL,
+    UINT,
+    BYTES,
+};
+
+struct NvsWrite {
+    const char* key;
+    NvsType type;
+    const void* data;   // bool: uint8_t 0/1, UINT: uint32_t, BYTES: size bytes
+    size_t size;
+};
+
+// Returns false if the namespace could not be opened or any write failed
+bool nvsPutBatch(const char* ns, const NvsWrite* writes, int count);
+
+// RTC memory: survives resets and watchdog/brownout reboots, not a power
+// cut. Writes cost nothing in flash wear. A few small checksummed slots;
+// rtcLoad() returns the slot's length, or 0 after a cold boot, a bad
+// checksum or an invalid slot.
+enum RtcSlot : int {
+    RTC_SLOT_SNAPSHOT,      // LampSnapshot
+    RTC_SLOT_WIFI,          // WifiCache
+    RTC_SLOT_COUNT,
+};
+static constexpr size_t RTC_SLOT_BYTES = 32;
+size_t rtcLoad(RtcSlot slot, void* data, size_t size);
+void rtcStore(RtcSlot slot, const void* data, size_t size);
+
+}  // namespace hal
+
+#endif
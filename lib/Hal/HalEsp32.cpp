@@ -0,0 +1,220 @@
+#ifdef ARDUINO
+
+#include "Hal.h"
+#include "Log.h"
+#include <Arduino.h>
+#include <Preferences.h>
+#include <driver/ledc.h>
+#include <esp_timer.h>
+#include <nvs.h>
+#include <string.h>
+
+namespace hal {
+
+namespace {
+
+// One timer for every channel (Arduino's ledcSetup() spreads channels over
+// timers by number, which leaves their periods out of phase)
+constexpr ledc_mode_t PWM_MODE = LEDC_LOW_SPEED_MODE;
+constexpr ledc_timer_t PWM_TIMER = LEDC_TIMER_0;
+portMUX_TYPE pwmLatchMux = portMUX_INITIALIZER_UNLOCKED;
+
+constexpr uint32_t RTC_MAGIC = 0x4c414d50;  // "LAMP"
+
+struct RtcRecord {
+    uint32_t magic;
+    uint32_t length;
+    uint32_t checksum;
+    uint8_t data[RTC_SLOT_BYTES];
+};
+
+// Left alone by the bootloader on a warm reset; garbage after power-up
+RTC_NOINIT_ATTR RtcRecord rtcRecords[RTC_SLOT_COUNT];
+
+// FNV-1a over length and payload
+uint32_t rtcChecksum(const uint8_t* data, uint32_t length) {
+    uint32_t hash = 2166136261u ^ length;
+    for (uint32_t i = 0; i < length; i++) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+}  // namespace
+
+uint32_t nowMs() {
+    return millis();
+}
+
+uint64_t nowUs() {
+    return static_cast<uint64_t>(esp_timer_get_time());
+}
+
+bool pwmSetup(int channel, uint32_t frequency, uint8_t resolutionBits) {
+    // Same settings for every channel; reconfiguring the shared timer is harmless
+    ledc_timer_config_t timer = {};
+    timer.speed_mode = PWM_MODE;
+    timer.duty_resolution = static_cast<ledc_timer_bit_t>(resolutionBits);
+    timer.timer_num = PWM_TIMER;
+    timer.freq_hz = frequency;
+    timer.clk_cfg = LEDC_AUTO_CLK;
+    esp_err_t err = ledc_timer_config(&timer);
+    if (err != ESP_OK) {
+        LOG_E("LEDC timer setup failed for channel %d (%lu Hz, %u bits): %s", channel, (unsigned long)frequency,
+              resolutionBits, esp_err_to_name(err));
+        return false;
+    }
+    return true;
+}
+
+bool pwmAttachPin(int pin, int channel) {
+    ledc_channel_config_t config = {};
+    config.gpio_num = pin;
+    config.speed_mode = PWM_MODE;
+    config.channel = static_cast<ledc_channel_t>(channel);
+    config.intr_type = LEDC_INTR_DISABLE;
+    config.timer_sel = PWM_TIMER;
+    config.duty = 0;
+    config.hpoint = 0;
+    esp_err_t err = ledc_channel_config(&config);
+    if (err != ESP_OK) {
+        LOG_E("LEDC channel %d setup failed on GPIO %d: %s", channel, pin, esp_err_to_name(err));
+        return false;
+    }
+    return true;
+}
+
+void pwmWrite(int channel, uint32_t duty) {
+    ledc_set_duty(PWM_MODE, static_cast<ledc_channel_t>(channel), duty);
+    ledc_update_duty(PWM_MODE, static_cast<ledc_channel_t>(channel));
+}
+
+void pwmStage(int channel, uint32_t duty) {
+    ledc_set_duty(PWM_MODE, static_cast<ledc_channel_t>(channel), duty);
+}
+
+void pwmLatch(uint32_t channelMask) {
+    // A few register writes, well inside one 52 us period, with no task
+    // switch or interrupt in between. Each channel still takes its duty at
+    // its own next period boundary, so a latch that lands near one can
+    // split across two periods
+    portENTER_CRITICAL(&pwmLatchMux);
+    for (int channel = 0; channelMask != 0; channel++, channelMask >>= 1) {
+        if (channelMask & 1) {
+            ledc_update_duty(PWM_MODE, static_cast<ledc_channel_t>(channel));
+        }
+    }
+    portEXIT_CRITICAL(&pwmLatchMux);
+}
+
+void gpioInput(int pin) {
+    pinMode(pin, INPUT);
+}
+
+int gpioRead(int pin) {
+    return digitalRead(pin);
+}
+
+bool nvsGetBool(const char* ns, const char* key, bool fallback) {
+    Preferences preferences;
+    preferences.begin(ns, true);
+    bool value = preferences.getBool(key, fallback);
+    preferences.end();
+    return value;
+}
+
+void nvsPutBool(const char* ns, const char* key, bool value) {
+    Preferences preferences;
+    preferences.begin(ns, false);
+    preferences.putBool(key, value);
+    preferences.end();
+}
+
+uint32_t nvsGetUInt(const char* ns, const char* key, uint32_t fallback) {
+    Preferences preferences;
+    preferences.begin(ns, true);
+    uint32_t value = preferences.getUInt(key, fallback);
+    preferences.end();
+    return value;
+}
+
+void nvsPutUInt(const char* ns, const char* key, uint32_t value) {
+    Preferences preferences;
+    preferences.begin(ns, false);
+    preferences.putUInt(key, value);
+    preferences.end();
+}
+
+size_t nvsGetBytes(const char* ns, const char* key, void* data, size_t size) {
+    Preferences preferences;
+    preferences.begin(ns, true);
+    size_t stored = preferences.getBytesLength(key);
+    size_t read = (stored > 0 && stored <= size) ? preferences.getBytes(key, data, size) : 0;
+    preferences.end();
+    return read;
+}
+
+void nvsPutBytes(const char* ns, const char* key, const void* data, size_t size) {
+    Preferences preferences;
+    preferences.begin(ns, false);
+    preferences.putBytes(key, data, size);
+    preferences.end();
+}
+
+size_t rtcLoad(RtcSlot slot, void* data, size_t size) {
+    if (slot < 0 || slot >= RTC_SLOT_COUNT) {
+        return 0;
+    }
+    const RtcRecord& record = rtcRecords[slot];
+    if (record.magic != RTC_MAGIC || record.length > RTC_SLOT_BYTES || record.length > size ||
+        record.checksum != rtcChecksum(record.data, record.length)) {
+        return 0;
+    }
+    memcpy(data, record.data, record.length);
+    return record.length;
+}
+
+void rtcStore(RtcSlot slot, const void* data, size_t size) {
+    if (slot < 0 || slot >= RTC_SLOT_COUNT || size > RTC_SLOT_BYTES) {
+        return;
+    }
+    RtcRecord& record = rtcRecords[slot];
+    record.magic = 0;  // Invalid while half-written
+    memcpy(record.data, data, size);
+    record.length = static_cast<uint32_t>(size);
+    record.checksum = rtcChecksum(record.data, record.length);
+    record.magic = RTC_MAGIC;
+}
+
+bool nvsPutBatch(const char* ns, const NvsWrite* writes, int count) {
+    // Straight to the IDF: Preferences commits after every put
+    nvs_handle_t handle;
+    if (nvs_open(ns, NVS_READWRITE, &handle) != ESP_OK) {
+        return false;
+    }
+    bool ok = true;
+    for (int i = 0; i < count; i++) {
+        const NvsWrite& write = writes[i];
+        esp_err_t err;
+        switch (write.type) {
+        case NvsType::BOOL:
+            err = nvs_set_u8(handle, write.key, *static_cast<const uint8_t*>(write.data));
+            break;
+        case NvsType::UINT:
+            err = nvs_set_u32(handle, write.key, *static_cast<const uint32_t*>(write.data));
+            break;
+        case NvsType::BYTES:
+        default:
+            err = nvs_set_blob(handle, write.key, write.data, write.size);
+            break;
+        }
+        ok = ok && err == ESP_OK;
+    }
+    ok = nvs_commit(handle) == ESP_OK && ok;
+    nvs_close(handle);
+    return ok;
+}
+
+}  // namespace hal
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef HAL_FAKE_H
+#define HAL_FAKE_H
+
+#include <stdint.h>
+#include "Hal.h"
+
+// Controls and inspection for the native backend (HalNative.cpp). Time only
+// moves when advanced; PWM, GPIO and NVS are plain in-memory state. A staged
+// PWM duty only shows in pwmDuty() once its channel is latched.
+namespace hal {
+namespace fake {
+
+static constexpr int MAX_PWM_CHANNELS = 8;
+static constexpr int MAX_PINS = 32;
+
+void setUs(uint64_t us);
+void advanceUs(uint64_t us);
+void advanceMs(uint32_t ms);
+
+uint32_t pwmDuty(int channel);
+uint32_t pwmWrites(int channel);    // Duties applied, by pwmWrite() or a latch
+uint32_t pwmLatches();
+uint32_t pwmStaged(int channel);    // Staged duty, applied on the next latch
+int pwmChannelForPin(int pin);      // -1 if the pin was never attached
+
+void setGpio(int pin, int level);
+
+uint32_t nvsWrites();     // Keys written
+uint32_t nvsCommits();    // Single puts plus batches
+void nvsClear();
+
+// Power cut: RTC memory is lost, NVS is kept
+void rtcClear();
+
+// Back to power-on state: time 0, PWM detached and off, GPIO high, NVS and
+// RTC empty
+void reset();
+
+}  // namespace fake
+}  // namespace hal
+
+#endif
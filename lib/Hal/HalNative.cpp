@@ -0,0 +1,255 @@
+#ifndef ARDUINO
+
+#include "HalFake.h"
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace hal {
+
+namespace {
+
+struct PwmChannel {
+    uint32_t duty = 0;
+    uint32_t staged = 0;
+    bool pending = false;
+    uint32_t writes = 0;
+};
+
+uint64_t fakeUs = 0;
+PwmChannel pwm[fake::MAX_PWM_CHANNELS];
+int pinChannel[fake::MAX_PINS];
+int gpioLevel[fake::MAX_PINS];
+std::map<std::string, std::vector<uint8_t>> nvs;
+uint32_t pwmLatchCount = 0;
+uint32_t nvsWriteCount = 0;
+uint32_t nvsCommitCount = 0;
+std::vector<uint8_t> rtc[RTC_SLOT_COUNT];
+
+bool validChannel(int channel) {
+    return channel >= 0 && channel < fake::MAX_PWM_CHANNELS;
+}
+
+bool validPin(int pin) {
+    return pin >= 0 && pin < fake::MAX_PINS;
+}
+
+std::string nvsKey(const char* ns, const char* key) {
+    return std::string(ns) + "/" + key;
+}
+
+void nvsStore(const char* ns, const char* key, const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    nvs[nvsKey(ns, key)].assign(bytes, bytes + size);
+    nvsWriteCount++;
+}
+
+bool nvsLoad(const char* ns, const char* key, void* data, size_t size) {
+    auto it = nvs.find(nvsKey(ns, key));
+    if (it == nvs.end() || it->second.size() != size) {
+        return false;
+    }
+    memcpy(data, it->second.data(), size);
+    return true;
+}
+
+struct PowerOn {
+    PowerOn() { fake::reset(); }
+} powerOn;
+
+}  // namespace
+
+uint32_t nowMs() {
+    return static_cast<uint32_t>(fakeUs / 1000);
+}
+
+uint64_t nowUs() {
+    return fakeUs;
+}
+
+bool pwmSetup(int channel, uint32_t frequency, uint8_t resolutionBits) {
+    return validChannel(channel);
+}
+
+bool pwmAttachPin(int pin, int channel) {
+    if (!validPin(pin) || !validChannel(channel)) {
+        return false;
+    }
+    pinChannel[pin] = channel;
+    return true;
+}
+
+void pwmWrite(int channel, uint32_t duty) {
+    if (validChannel(channel)) {
+        pwm[channel].duty = duty;
+        pwm[channel].pending = false;
+        pwm[channel].writes++;
+    }
+}
+
+void pwmStage(int channel, uint32_t duty) {
+    if (validChannel(channel)) {
+        pwm[channel].staged = duty;
+        pwm[channel].pending = true;
+    }
+}
+
+void pwmLatch(uint32_t channelMask) {
+    pwmLatchCount++;
+    for (int channel = 0; channel < fake::MAX_PWM_CHANNELS; channel++) {
+        if ((channelMask & (1u << channel)) && pwm[channel].pending) {
+            pwm[channel].duty = pwm[channel].staged;
+            pwm[channel].pending = false;
+            pwm[channel].writes++;
+        }
+    }
+}
+
+void gpioInput(int pin) {
+}
+
+int gpioRead(int pin) {
+    return validPin(pin) ? gpioLevel[pin] : 0;
+}
+
+bool nvsGetBool(const char* ns, const char* key, bool fallback) {
+    uint8_t value;
+    return nvsLoad(ns, key, &value, sizeof(value)) ? value != 0 : fallback;
+}
+
+void nvsPutBool(const char* ns, const char* key, bool value) {
+    uint8_t stored = value ? 1 : 0;
+    nvsStore(ns, key, &stored, sizeof(stored));
+    nvsCommitCount++;
+}
+
+uint32_t nvsGetUInt(const char* ns, const char* key, uint32_t fallback) {
+    uint32_t value;
+    return nvsLoad(ns, key, &value, sizeof(value)) ? value : fallback;
+}
+
+void nvsPutUInt(const char* ns, const char* key, uint32_t value) {
+    nvsStore(ns, key, &value, sizeof(value));
+    nvsCommitCount++;
+}
+
+size_t nvsGetBytes(const char* ns, const char* key, void* data, size_t size) {
+    auto it = nvs.find(nvsKey(ns, key));
+    if (it == nvs.end() || it->second.empty() || it->second.size() > size) {
+        return 0;
+    }
+    memcpy(data, it->second.data(), it->second.size());
+    return it->second.size();
+}
+
+void nvsPutBytes(const char* ns, const char* key, const void* data, size_t size) {
+    nvsStore(ns, key, data, size);
+    nvsCommitCount++;
+}
+
+bool nvsPutBatch(const char* ns, const NvsWrite* writes, int count) {
+    for (int i = 0; i < count; i++) {
+        const NvsWrite& write = writes[i];
+        size_t size = write.type == NvsType::BOOL ? sizeof(uint8_t)
+                    : write.type == NvsType::UINT ? sizeof(uint32_t) : write.size;
+        nvsStore(ns, write.key, write.data, size);
+    }
+    nvsCommitCount++;
+    return true;
+}
+
+size_t rtcLoad(RtcSlot slot, void* data, size_t size) {
+    if (slot < 0 || slot >= RTC_SLOT_COUNT || rtc[slot].empty() || rtc[slot].size() > size) {
+        return 0;
+    }
+    memcpy(data, rtc[slot].data(), rtc[slot].size());
+    return rtc[slot].size();
+}
+
+void rtcStore(RtcSlot slot, const void* data, size_t size) {
+    if (slot >= 0 && slot < RTC_SLOT_COUNT && size <= RTC_SLOT_BYTES) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        rtc[slot].assign(bytes, bytes + size);
+    }
+}
+
+namespace fake {
+
+void setUs(uint64_t us) {
+    fakeUs = us;
+}
+
+void advanceUs(uint64_t us) {
+    fakeUs += us;
+}
+
+void advanceMs(uint32_t ms) {
+    fakeUs += static_cast<uint64_t>(ms) * 1000;
+}
+
+uint32_t pwmDuty(int channel) {
+    return validChannel(channel) ? pwm[channel].duty : 0;
+}
+
+uint32_t pwmWrites(int channel) {
+    return validChannel(channel) ? pwm[channel].writes : 0;
+}
+
+uint32_t pwmLatches() {
+    return pwmLatchCount;
+}
+
+uint32_t pwmStaged(int channel) {
+    return validChannel(channel) ? pwm[channel].staged : 0;
+}
+
+int pwmChannelForPin(int pin) {
+    return validPin(pin) ? pinChannel[pin] : -1;
+}
+
+void setGpio(int pin, int level) {
+    if (validPin(pin)) {
+        gpioLevel[pin] = level;
+    }
+}
+
+uint32_t nvsWrites() {
+    return nvsWriteCount;
+}
+
+uint32_t nvsCommits() {
+    return nvsCommitCount;
+}
+
+void nvsClear() {
+    nvs.clear();
+    nvsWriteCount = 0;
+    nvsCommitCount = 0;
+}
+
+void rtcClear() {
+    for (int i = 0; i < RTC_SLOT_COUNT; i++) {
+        rtc[i].clear();
+    }
+}
+
+void reset() {
+    fakeUs = 0;
+    for (int i = 0; i < MAX_PWM_CHANNELS; i++) {
+        pwm[i] = PwmChannel();
+    }
+    pwmLatchCount = 0;
+    for (int i = 0; i < MAX_PINS; i++) {
+        pinChannel[i] = -1;
+        gpioLevel[i] = 1;   // Pulled up, like the mode button at rest
+    }
+    nvsClear();
+    rtcClear();
+}
+
+}  // namespace fake
+
+}  // namespace hal
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef BLINK_PATTERN_H
+#define BLINK_PATTERN_H
+
+#include "LEDController.h"
+
+// Non-blocking on/off blink, stepped from a scheduler group. While
+// update() returns true the pattern owns the LEDs and callers should not
+// write their own color.
+class BlinkPattern {
+private:
+    LEDController& ledController;
+    int color[COLOR_CHANNELS] = {0};
+    int togglesLeft = 0;
+    unsigned long halfPeriodMs = 0;
+    unsigned long nextToggleMs = 0;
+    bool lit = false;
+    bool active = false;
+
+public:
+    explicit BlinkPattern(LEDController& controller) : ledController(controller) {}
+
+    void start(int red, int green, int blue, int blinks, unsigned long halfPeriod, unsigned long nowMs) {
+        color[0] = red;
+        color[1] = green;
+        color[2] = blue;
+        togglesLeft = blinks * 2;
+        halfPeriodMs = halfPeriod;
+        nextToggleMs = nowMs;
+        lit = false;
+        active = togglesLeft > 0;
+    }
+
+    bool update(unsigned long nowMs) {
+        if (!active) {
+            return false;
+        }
+        bool due = (long)(nowMs - nextToggleMs) >= 0;
+        if (togglesLeft == 0) {
+            // Hold the final "off" for a half period before handing back
+            active = !due;
+            return active;
+        }
+        if (due) {
+            lit = !lit;
+            if (lit) {
+                ledController.setPWMForced(color[0], color[1], color[2]);
+            } else {
+                ledController.setPWMForced(0, 0, 0);
+            }
+            togglesLeft--;
+            nextToggleMs += halfPeriodMs;
+        }
+        return true;
+    }
+};
+
+#endif
@@ -1,45 +1,37 @@
 #include "LEDController.h"
+#include "Log.h"
+#include "Hal.h"
+#include <stdlib.h>
 
 LEDController::LEDController(
-    int rPin, int gPin, int bPin,
-    int rChannel, int gChannel, int bChannel,
+    SettingsStore& store,
+    PowerGovernor& powerGovernor,
+    LedOutputBase& ledOutput,
+    TemporalDither& temporalDither,
     int freq, int res
-) : redPin(rPin), 
-    greenPin(gPin), 
-    bluePin(bPin),
-    redChannel(rChannel), 
-    greenChannel(gChannel), 
-    blueChannel(bChannel),
+) : settings(store),
+    governor(powerGovernor),
+    output(ledOutput),
+    dither(temporalDither),
     frequency(freq), 
     resolution(res) 
 {
 }
 
 void LEDController::begin() {
-    // Configure LED PWM channels
-    ledcSetup(redChannel, frequency, resolution);
-    ledcSetup(greenChannel, frequency, resolution);
-    ledcSetup(blueChannel, frequency, resolution);
-    
-    // Attach PWM channels to GPIO pins, but swap red and blue
-    ledcAttachPin(redPin, blueChannel);    // Red pin gets blue channel
-    ledcAttachPin(greenPin, greenChannel); // Green stays same
-    ledcAttachPin(bluePin, redChannel);    // Blue pin gets red channel
-    
-    // Initialize all LEDs to off
-    ledcWrite(redChannel, 0);
-    ledcWrite(greenChannel, 0);
-    ledcWrite(blueChannel, 0);
+    // Configure LED PWM channels from the pin map and turn them off;
+    // output indexes 0-2 are red, green, blue
+    if (!output.begin(frequency, resolution)) {
+        LOG_E("LED output setup failed - check the pin map; the lamp stays dark");
+    }
 
     loadPowerLimit();
 }
 
 void LEDController::updatePowerLimitFromPreferences() {
-    preferences.begin("led", false);
-    bool unlocked = preferences.getBool("unlocked", false);
-    currentPowerLimit = unlocked ? UNLOCKED_POWER_LIMIT : LOCKED_POWER_LIMIT;
-    preferences.end();
-    Serial.printf("Power limit updated to: %f\n", currentPowerLimit);
+    unlocked = settings.getBool("unlocked", false);
+    setCurrentPowerLimit(unlocked ? UNLOCKED_POWER_LIMIT : LOCKED_POWER_LIMIT);
+    LOG_I("Power limit updated to: %f", currentPowerLimit);
 }
 
 void LEDController::loadPowerLimit() {
@@ -51,52 +43,93 @@ void LEDController::checkAndUpdatePowerLimit() {
 }
 
 void LEDController::unlock() {
-    preferences.begin("led", false);
-    preferences.putBool("unlocked", true);
-    preferences.end();
-    currentPowerLimit = UNLOCKED_POWER_LIMIT;
+    settings.putBool("unlocked", true);
+    unlocked = true;
+    setCurrentPowerLimit(UNLOCKED_POWER_LIMIT);
 }
 
 void LEDController::resetToSafeMode() {
-    preferences.begin("led", false);
-    preferences.putBool("unlocked", false);
-    preferences.end();
-    currentPowerLimit = LOCKED_POWER_LIMIT;
+    settings.putBool("unlocked", false);
+    // Don't leave a power cut inside the debounce able to restore full power
+    settings.flush();
+    unlocked = false;
+    setCurrentPowerLimit(LOCKED_POWER_LIMIT);
+}
+
+void LEDController::setCurrentPowerLimit(float limit) {
+    currentPowerLimit = limit;
+    governor.setSustainedLimit(limit);
+    governor.setPeakLimit(unlocked ? UNLOCKED_PEAK_LIMIT : LOCKED_PEAK_LIMIT);
 }
 
 void LEDController::setPowerLimit(float limit) {
-    currentPowerLimit = constrain(limit, 0.0f, 1.0f);
+    setCurrentPowerLimit(limit < 0.0f ? 0.0f : (limit > 1.0f ? 1.0f : limit));
 }
 
 void LEDController::setRGBModePowerLimit() {
-    currentPowerLimit = RGB_MODE_POWER_LIMIT;
-    Serial.printf("Power limit set to RGB mode: %f (30%%)\n", currentPowerLimit);
+    setCurrentPowerLimit(RGB_MODE_POWER_LIMIT);
+    LOG_I("Power limit set to RGB mode: %f sustained", currentPowerLimit);
 }
 
 void LEDController::setMQTTModePowerLimit() {
-    currentPowerLimit = MQTT_MODE_POWER_LIMIT;
-    Serial.printf("Power limit set to MQTT mode: %f (80%%)\n", currentPowerLimit);
+    setCurrentPowerLimit(MQTT_MODE_POWER_LIMIT);
+    LOG_I("Power limit set to MQTT mode: %f sustained", currentPowerLimit);
 }
 
-void LEDController::setPWMForced(int red, int green, int blue) {
-    // Constrain values first
-    red = constrain(red, 0, 2047);
-    green = constrain(green, 0, 2047);
-    blue = constrain(blue, 0, 2047);
+void LEDController::updatePower(uint32_t nowMs) {
+    int duty[COLOR_CHANNELS] = {currentRed, currentGreen, currentBlue};
+    if (!governor.update(duty, nowMs)) {
+        return;
+    }
+    for (int c = 0; c < COLOR_CHANNELS; c++) {
+        writeColor(c, currentFine[c]);
+    }
+    latchColors();
+}
 
-    // Apply RGB trim values
-    red = static_cast<int>(red * RED_TRIM);
-    green = static_cast<int>(green * GREEN_TRIM);
-    blue = static_cast<int>(blue * BLUE_TRIM);
+void LEDController::setPWMForced(int red, int green, int blue) {
+    LinearColor duty = LampPipeline::run(color_source::fromDuty(red, green, blue));
 
     // Force update without shouldUpdate check
-    currentRed = red;
-    currentGreen = green;
-    currentBlue = blue;
-    
-    writePWM(redChannel, red);
-    writePWM(greenChannel, green);
-    writePWM(blueChannel, blue);
+    for (int c = 0; c < COLOR_CHANNELS; c++) {
+        writeColor(c, duty.c[c]);
+    }
+    latchColors();
+}
+
+void LEDController::setColor8(uint8_t red, uint8_t green, uint8_t blue) {
+    show(color_source::fromColor8(red, green, blue));
+}
+
+void LEDController::writeDutiesFine(int red, int green, int blue) {
+    if (red == currentFine[0] && green == currentFine[1] && blue == currentFine[2]) {
+        return;
+    }
+    writeColor(0, red);
+    writeColor(1, green);
+    writeColor(2, blue);
+    latchColors();
+}
+
+// Stages one color; current* keep the 11-bit integer part for fades and
+// the knob threshold. Nothing is shown until latchColors().
+void LEDController::writeColor(int color, int fine) {
+    currentFine[color] = fine;
+    int duty = fine >> DITHER_BITS;
+    switch (color) {
+    case 0:
+        currentRed = duty;
+        break;
+    case 1:
+        currentGreen = duty;
+        break;
+    default:
+        currentBlue = duty;
+        break;
+    }
+    // One shared scale from the power governor, see updatePower(); scaling
+    // the fine duty keeps the throttled output's low bits for the dither
+    dither.set(color, governor.scale(fine));
 }
 
 void LEDController::applyPowerLimit(int& red, int& green, int& blue) {
@@ -109,54 +142,51 @@ void LEDController::applyPowerLimit(int& red, int& green, int& blue) {
     }
 }
 
-void LEDController::writePWM(int channel, int value) {
-    value = static_cast<int>(value * currentPowerLimit);
-    ledcWrite(channel, value);
+// All three colors are latched in one burst (see hal::pwmLatch). The peak cap is
+// checked here so no write path can latch above it, even between ticks.
+void LEDController::latchColors() {
+    int duty[COLOR_CHANNELS] = {currentRed, currentGreen, currentBlue};
+    if (governor.limitPeak(duty)) {
+        for (int c = 0; c < COLOR_CHANNELS; c++) {
+            dither.set(c, governor.scale(currentFine[c]));
+        }
+    }
+    dither.commit();
 }
 
 void LEDController::setPWMDirectly(int red, int green, int blue) {
-    // Constrain values first
-    red = constrain(red, 0, 2047);
-    green = constrain(green, 0, 2047);
-    blue = constrain(blue, 0, 2047);
-
-    // Apply RGB trim values
-    red = static_cast<int>(red * RED_TRIM);
-    green = static_cast<int>(green * GREEN_TRIM);
-    blue = static_cast<int>(blue * BLUE_TRIM);
+    LinearColor duty = LampPipeline::run(color_source::fromDuty(red, green, blue));
 
-    bool updateRed = shouldUpdate(currentRed, red);
-    bool updateGreen = shouldUpdate(currentGreen, green);
-    bool updateBlue = shouldUpdate(currentBlue, blue);
+    // Knob hysteresis on the 11-bit duties
+    bool updateRed = shouldUpdate(currentRed, duty.c[0] >> DITHER_BITS);
+    bool updateGreen = shouldUpdate(currentGreen, duty.c[1] >> DITHER_BITS);
+    bool updateBlue = shouldUpdate(currentBlue, duty.c[2] >> DITHER_BITS);
 
     #ifdef DEBUG_LED
-    if (Serial) {
-        Serial.printf("DEBUG: Writing to channels - Red(ch%d): %d, Green(ch%d): %d, Blue(ch%d): %d\n",
-        redChannel, red, greenChannel, green, blueChannel, blue);
-    }
+    LOG_D("Writing to channels - Red(ch%d): %d, Green(ch%d): %d, Blue(ch%d): %d",
+          output.channel(0), duty.c[0] >> DITHER_BITS, output.channel(1), duty.c[1] >> DITHER_BITS,
+          output.channel(2), duty.c[2] >> DITHER_BITS);
     #endif
 
     if (updateRed || updateGreen || updateBlue) {
         if (updateRed) {
-            currentRed = red;
-            writePWM(redChannel, red);
+            writeColor(0, duty.c[0]);
         }
         if (updateGreen) {
-            currentGreen = green;
-            writePWM(greenChannel, green);
+            writeColor(1, duty.c[1]);
         }
         if (updateBlue) {
-            currentBlue = blue;
-            writePWM(blueChannel, blue);
+            writeColor(2, duty.c[2]);
         }
+        latchColors();
     }
 }
 
 bool LEDController::shouldUpdate(int current, int new_value) {
     if(abs(current - new_value) > noiseThreshold){ //if the noise threshold is exceeded
-        lastChangeTime = millis(); //start a timer
+        lastChangeTime = hal::nowMs(); //start a timer
         updateThreshold = minThreshold; //make the pots sensative
-    } else if (millis() - lastChangeTime > idleTimeThreshold) { //if the timer is up
+    } else if (hal::nowMs() - lastChangeTime > idleTimeThreshold) { //if the timer is up
             updateThreshold = noiseThreshold;
         }
     
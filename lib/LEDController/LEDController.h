@@ -1,41 +1,48 @@
 #ifndef LED_CONTROLLER_H
 #define LED_CONTROLLER_H
 
-#include <Arduino.h>
-#include <Preferences.h>
-
-static constexpr float RED_TRIM = 0.95f;   // Adjust these between 0.0-1.0
-static constexpr float GREEN_TRIM = 1.0f;  // to trim individual colors
-static constexpr float BLUE_TRIM = 0.80f; 
+#include <stdint.h>
+#include "PwmTables.h"
+#include "ColorPipeline.h"
+#include "SettingsStore.h"
+#include "PowerGovernor.h"
+#include "LedOutput.h"
+#include "TemporalDither.h"
 
 class LEDController {
 private:
-    const int redPin;
-    const int greenPin;
-    const int bluePin;
+    SettingsStore& settings;
+    PowerGovernor& governor;
+    LedOutputBase& output;
+    TemporalDither& dither;
     const int frequency;
     const int resolution;
-    const int redChannel;
-    const int greenChannel;
-    const int blueChannel;
     int currentRed = 0;
     int currentGreen = 0;
     int currentBlue = 0;
+    int currentFine[COLOR_CHANNELS] = {0};  // What current* were cut from, with the dither fraction
     //int updateThreshold = 30;
     //bool shouldUpdate(int current, int new_value);
 
 //    Set Limits by Mode instead of Lock/Unlock
+//    These are sustained limits for the power governor: bursts above them
+//    run until the thermal budget is used up, then ramp down onto them.
+//    The peak limits are a separate safety ceiling on the instantaneous
+//    power, lower while the lamp is locked
 
     static constexpr float LOCKED_POWER_LIMIT = 0.3f;   // 30% power
     static constexpr float UNLOCKED_POWER_LIMIT = 0.6f; // 60% power
     static constexpr float RGB_MODE_POWER_LIMIT = 0.3f; // 30% power for RGB mode
     static constexpr float MQTT_MODE_POWER_LIMIT = 0.6f; // 60% power for MQTT mode
+    static constexpr float LOCKED_PEAK_LIMIT = 0.8f;    // 80% power at any instant
+    static constexpr float UNLOCKED_PEAK_LIMIT = 1.0f;  // No ceiling beyond the thermal model
     float currentPowerLimit;
-    Preferences preferences;
+    bool unlocked = false;
     
-    void applyPowerLimit(int& red, int& green, int& blue);
     void loadPowerLimit();
-    void writePWM(int channel, int value);
+    void setCurrentPowerLimit(float limit);
+    void writeColor(int color, int fine);
+    void latchColors();
     void updatePowerLimitFromPreferences();
 
 
@@ -48,27 +55,50 @@ private:
 
 public:
     LEDController(
-        int redPin, int greenPin, int bluePin,
-        int redChannel = 0, int greenChannel = 1, int blueChannel = 2,
+        SettingsStore& settings,
+        PowerGovernor& governor,
+        LedOutputBase& output,     // Pin map with red, green, blue first
+        TemporalDither& dither,
         int frequency = 19000, int resolution = 11
     );
     void begin();
     void setPWMDirectly(int red, int green, int blue);
     void setPWMForced(int red, int green, int blue);
+    // 8-bit color (web UI) through the color pipeline
+    void setColor8(uint8_t red, uint8_t green, uint8_t blue);
+    // Any source's linear color through LampPipeline (effects, LTT)
+    void show(const LinearColor& color) {
+        LinearColor duty = LampPipeline::run(color);
+        writeDutiesFine(duty.c[0], duty.c[1], duty.c[2]);
+    }
+    // Pipeline output: trimmed fine duties, 0..PWM_FINE_MAX. Power and
+    // output, the last two stages, run here; fades interpolate these.
+    void writeDutiesFine(int red, int green, int blue);
     void getPWMValues(int& red, int& green, int& blue) {
         red = currentRed;
         green = currentGreen;
         blue = currentBlue;
     }
-    bool isUnlocked() const { return currentPowerLimit > LOCKED_POWER_LIMIT; }
+    void getFineValues(int& red, int& green, int& blue) {
+        red = currentFine[0];
+        green = currentFine[1];
+        blue = currentFine[2];
+    }
+    bool isUnlocked() const { return unlocked; }
     void unlock();
     void resetToSafeMode();
     void checkAndUpdatePowerLimit();
     void setPowerLimit(float limit);
     void setRGBModePowerLimit();
     void setMQTTModePowerLimit();
+    // Steps the power governor with the current duties and rewrites the
+    // channels if its output scale moved. Call from the control loop.
+    void updatePower(uint32_t nowMs);
 
     bool shouldUpdate(int current, int new_value);
+    // Per-write static float cap the power governor replaced; kept as the
+    // reference for the benchmark suite
+    void applyPowerLimit(int& red, int& green, int& blue);
     void adjustThreshold(int current, int new_value);
 };
 
@@ -0,0 +1,106 @@
+#ifndef PWM_TABLES_H
+#define PWM_TABLES_H
+
+#include <stdint.h>
+
+static constexpr float RED_TRIM = 0.95f;   // Adjust these between 0.0-1.0
+static constexpr float GREEN_TRIM = 1.0f;  // to trim individual colors
+static constexpr float BLUE_TRIM = 0.80f;
+
+// Gamma applied to 8-bit colors from Home Assistant and the web UI. Set to
+// 1.0 for a linear response. The knobs are already perceptually tuned and
+// stay linear.
+static constexpr double LED_GAMMA = 2.2;
+
+static constexpr int PWM_MAX = 2047;       // 11-bit LEDC duty
+static constexpr int PWM_LEVELS = PWM_MAX + 1;
+static constexpr int COLOR_CHANNELS = 3;   // Indexed red, green, blue
+
+// Fine duties carry DITHER_BITS of fraction below the 11-bit LEDC duty;
+// TemporalDither spreads the fraction over successive PWM updates
+static constexpr int DITHER_BITS = 4;
+static constexpr int PWM_FINE_MAX = PWM_MAX << DITHER_BITS;
+
+constexpr int clampDuty(int duty) {
+    return duty < 0 ? 0 : (duty > PWM_MAX ? PWM_MAX : duty);
+}
+
+namespace pwm_detail {
+
+// constexpr ln/exp good to ~1e-12 - plenty for an 11-bit table
+constexpr double ln(double x) {
+    int exponent = 0;
+    while (x >= 1.0) { x *= 0.5; exponent++; }
+    while (x < 0.5) { x *= 2.0; exponent--; }
+    double z = (x - 1.0) / (x + 1.0);
+    double z2 = z * z;
+    double term = z;
+    double sum = 0.0;
+    for (int k = 1; k < 41; k += 2) {
+        sum += term / k;
+        term *= z2;
+    }
+    return 2.0 * sum + exponent * 0.69314718055994530942;
+}
+
+constexpr double exp(double y) {
+    int halvings = 0;
+    while (y < -0.25 || y > 0.25) { y *= 0.5; halvings++; }
+    double term = 1.0;
+    double sum = 1.0;
+    for (int k = 1; k < 16; k++) {
+        term *= y / k;
+        sum += term;
+    }
+    while (halvings-- > 0) {
+        sum *= sum;
+    }
+    return sum;
+}
+
+constexpr double pow(double x, double power) {
+    return x <= 0.0 ? 0.0 : exp(power * ln(x));
+}
+
+constexpr float channelTrim(int channel) {
+    return channel == 0 ? RED_TRIM : (channel == 1 ? GREEN_TRIM : BLUE_TRIM);
+}
+
+}  // namespace pwm_detail
+
+// Channel trims in Q15, the trim stage of the color pipeline. The trim is
+// not folded into per-channel copies of level8Fine: color correction has
+// to see untrimmed linear light, and every source (knobs, CCT, effects)
+// shares this one stage. There is no power table either; the governor's
+// scale changes every control tick, so it is one multiply in scale().
+inline constexpr int TRIM_Q15[COLOR_CHANNELS] = {
+    static_cast<int>(RED_TRIM * 32768.0 + 0.5),
+    static_cast<int>(GREEN_TRIM * 32768.0 + 0.5),
+    static_cast<int>(BLUE_TRIM * 32768.0 + 0.5),
+};
+
+constexpr int trimFine(int channel, int fine) {
+    return (fine * TRIM_Q15[channel]) >> 15;
+}
+
+// Gamma-expanded fine level for an 8-bit level, untrimmed; the source
+// stage of the color pipeline for 8-bit colors and brightness. Generated
+// at compile time, one load replaces a pow().
+struct PwmTables {
+    uint16_t level8Fine[256] = {};
+
+    constexpr PwmTables() {
+        for (int level = 0; level < 256; level++) {
+            level8Fine[level] = static_cast<uint16_t>(pwm_detail::pow(level / 255.0, LED_GAMMA) * PWM_FINE_MAX + 0.5);
+        }
+    }
+};
+
+inline constexpr PwmTables PWM_TABLES{};
+
+// Spot checks against the float math the table replaces
+static_assert(PWM_TABLES.level8Fine[0] == 0 && PWM_TABLES.level8Fine[255] == PWM_FINE_MAX, "level table endpoints");
+static_assert(trimFine(1, PWM_FINE_MAX) == PWM_FINE_MAX, "green is untrimmed");
+static_assert(PWM_TABLES.level8Fine[3] > 0, "fine levels resolve the darkest 8-bit levels");
+
+#endif
@@ -13,13 +13,30 @@ void LTTController::lttToRgb(int luminance, int temperature, int tintVal, int& r
     g = static_cast<int>(baseG * l * 2047);
     b = static_cast<int>(baseB * l * 2047);
     
-    r = constrain(r, 0, 2047);
-    g = constrain(g, 0, 2047);
-    b = constrain(b, 0, 2047);
+    r = clampDuty(r);
+    g = clampDuty(g);
+    b = clampDuty(b);
+}
+
+LinearColor LTTController::lttToColor(int luminance, int temperature, int tint) {
+    return color_source::fromKelvin(cct::knobToKelvin(temperature), cct::knobToDuv(tint),
+                                    clampDuty(luminance) << DITHER_BITS);
 }
 
 void LTTController::updateLTT(int luminance, int temperature, int tint) {
-    int r, g, b;
-    lttToRgb(luminance, temperature, tint, r, g, b);
-    ledController.setPWMDirectly(r, g, b);
-}
\ No newline at end of file
+    // Same knob hysteresis setPWMDirectly() applies, but on the knobs:
+    // a noisy temperature knob would otherwise wobble every channel
+    int knobs[3] = {luminance, temperature, tint};
+    bool moved = lastKnobs[0] < 0;
+    for (int i = 0; i < 3; i++) {
+        moved = ledController.shouldUpdate(lastKnobs[i], knobs[i]) || moved;
+    }
+    if (!moved) {
+        return;
+    }
+    for (int i = 0; i < 3; i++) {
+        lastKnobs[i] = knobs[i];
+    }
+
+    ledController.show(lttToColor(luminance, temperature, tint));
+}
@@ -2,15 +2,27 @@
 #define LTT_CONTROLLER_H
 
 #include "LEDController.h"
+#include "ColorPipeline.h"
 
+// Luminance / temperature / tint from the knobs. Temperature and tint go
+// through the Planckian table in ColorTemperature.h; luminance is the
+// linear output of the brightest channel. The result is a pipeline source
+// like any other; trim and correction come from LampPipeline.
 class LTTController {
 private:
     LEDController& ledController;
-    void lttToRgb(int luminance, int temperature, int tintVal, int& r, int& g, int& b);
+    int lastKnobs[3] = {-1, -1, -1};
 
 public:
     LTTController(LEDController& controller) : ledController(controller) {}
+    // Linear mix the CCT engine replaced; kept as the reference for the
+    // benchmark suite
+    static void lttToRgb(int luminance, int temperature, int tintVal, int& r, int& g, int& b);
+    // Linear color for knob positions (0..PWM_MAX each)
+    static LinearColor lttToColor(int luminance, int temperature, int tint);
     void updateLTT(int luminance, int temperature, int tint);
+    // Rewrites the output on the next update even if no knob moved
+    void invalidate() { lastKnobs[0] = -1; }
 };
 
-#endif
\ No newline at end of file
+#endif
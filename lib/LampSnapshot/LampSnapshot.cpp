@@ -0,0 +1,71 @@
+#include "LampSnapshot.h"
+#include "EffectsEngine.h"
+#include "Hal.h"
+
+void SnapshotKeeper::encode(const LampSnapshot& snapshot, uint8_t bytes[ENCODED_BYTES]) {
+    bytes[0] = VERSION;
+    bytes[1] = snapshot.mode;
+    bytes[2] = snapshot.light.on ? 1 : 0;
+    bytes[3] = snapshot.light.color.rgb[0];
+    bytes[4] = snapshot.light.color.rgb[1];
+    bytes[5] = snapshot.light.color.rgb[2];
+    bytes[6] = static_cast<uint8_t>(snapshot.light.effect);
+    bytes[7] = snapshot.light.color.kelvin & 0xFF;
+    bytes[8] = snapshot.light.color.kelvin >> 8;
+    bytes[9] = snapshot.light.color.brightness;
+}
+
+bool SnapshotKeeper::decode(const uint8_t* bytes, size_t length, LampSnapshot& snapshot) {
+    if (length != ENCODED_BYTES || bytes[0] != VERSION || bytes[6] >= EffectsEngine::EFFECT_COUNT) {
+        return false;
+    }
+    ColorState& color = snapshot.light.color;
+    snapshot.mode = bytes[1];
+    snapshot.light.on = bytes[2] != 0;
+    color.rgb[0] = bytes[3];
+    color.rgb[1] = bytes[4];
+    color.rgb[2] = bytes[5];
+    snapshot.light.effect = static_cast<Effect>(bytes[6]);
+    color.kelvin = static_cast<uint16_t>(bytes[7] | (bytes[8] << 8));
+    color.brightness = bytes[9];
+    return true;
+}
+
+SnapshotSource SnapshotKeeper::restore(LampSnapshot& snapshot) {
+    uint8_t stored[ENCODED_BYTES];
+    uint8_t rtc[hal::RTC_SLOT_BYTES];
+    bool fromNvs = decode(stored, settings.getBytes(KEY, stored, sizeof(stored)), snapshot);
+    bool fromRtc = decode(rtc, hal::rtcLoad(hal::RTC_SLOT_SNAPSHOT, rtc, sizeof(rtc)), snapshot);
+
+    SnapshotSource source = fromRtc ? SnapshotSource::RTC : (fromNvs ? SnapshotSource::NVS : SnapshotSource::NONE);
+    if (source != SnapshotSource::NONE) {
+        // A reset inside the debounce leaves flash behind RTC; the store
+        // only queues a flash write if they actually differ
+        save(snapshot);
+    }
+    return source;
+}
+
+bool SnapshotKeeper::save(const LampSnapshot& snapshot) {
+    if (haveLast && snapshot == last) {
+        return false;
+    }
+    last = snapshot;
+    haveLast = true;
+    saves++;
+
+    uint8_t bytes[ENCODED_BYTES];
+    encode(snapshot, bytes);
+    hal::rtcStore(hal::RTC_SLOT_SNAPSHOT, bytes, sizeof(bytes));
+    settings.putBytes(KEY, bytes, sizeof(bytes));
+    return true;
+}
+
+const char* SnapshotKeeper::sourceName(SnapshotSource source) {
+    switch (source) {
+    case SnapshotSource::RTC: return "rtc";
+    case SnapshotSource::NVS: return "nvs";
+    case SnapshotSource::NONE:
+    default: return "none";
+    }
+}
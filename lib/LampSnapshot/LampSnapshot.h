@@ -0,0 +1,59 @@
+#ifndef LAMP_SNAPSHOT_H
+#define LAMP_SNAPSHOT_H
+
+#include <stdint.h>
+#include "LightCommand.h"
+#include "SettingsStore.h"
+
+// What the lamp was showing: operating mode plus the Home Assistant light
+// state. Restored in setup() so a reboot lights up straight away instead
+// of waiting for WiFi, the broker and a command.
+struct LampSnapshot {
+    uint8_t mode = 0;       // OperationMode, stored as its value
+    LightState light;
+
+    bool operator==(const LampSnapshot& other) const {
+        return mode == other.mode && light.on == other.light.on && light.color == other.light.color &&
+               light.effect == other.light.effect;
+    }
+    bool operator!=(const LampSnapshot& other) const { return !(*this == other); }
+};
+
+enum class SnapshotSource : uint8_t {
+    NONE,   // First boot, or nothing valid stored
+    RTC,    // Warm reset: RTC memory, always the latest state
+    NVS,    // Power cut: flash, up to the settings debounce old
+};
+
+// Keeps the snapshot in RTC memory (written on every change, no wear) and
+// in the settings store (flash, debounced and batched there).
+class SnapshotKeeper {
+public:
+    static constexpr uint8_t VERSION = 1;
+    static constexpr const char* KEY = "snapshot";
+
+private:
+    static constexpr int ENCODED_BYTES = 10;
+
+    SettingsStore& settings;
+    LampSnapshot last;
+    bool haveLast = false;
+    uint32_t saves = 0;
+
+    static void encode(const LampSnapshot& snapshot, uint8_t bytes[ENCODED_BYTES]);
+    static bool decode(const uint8_t* bytes, size_t length, LampSnapshot& snapshot);
+
+public:
+    explicit SnapshotKeeper(SettingsStore& store) : settings(store) {}
+
+    // setup(): RTC if it survived the reset, else NVS
+    SnapshotSource restore(LampSnapshot& snapshot);
+
+    // Control loop: a compare when nothing changed. Returns true if it saved.
+    bool save(const LampSnapshot& snapshot);
+
+    uint32_t getSaveCount() const { return saves; }
+    static const char* sourceName(SnapshotSource source);
+};
+
+#endif
@@ -0,0 +1,158 @@
+#include "LatencyTrace.h"
+#include <stdio.h>
+#include <atomic>
+
+#ifdef ARDUINO
+#include <freertos/FreeRTOS.h>
+#endif
+
+namespace LatencyTrace {
+
+namespace {
+
+const char* const STAGE_NAMES[STAGE_COUNT] = {
+    "mqtt_parse", "mqtt_queue", "mqtt_output", "mqtt_total", "web_total"
+};
+
+Histogram histograms[STAGE_COUNT];
+uint32_t expired = 0;
+
+// The stages are recorded from the network task, the control loop and the
+// dither tick, and read from the web and MQTT handlers. A record is a few
+// dozen instructions, short enough for a critical section.
+#ifdef ARDUINO
+portMUX_TYPE histogramLock = portMUX_INITIALIZER_UNLOCKED;
+
+void lock() {
+    portENTER_CRITICAL(&histogramLock);
+}
+
+void unlock() {
+    portEXIT_CRITICAL(&histogramLock);
+}
+#else
+void lock() {}
+void unlock() {}
+#endif
+
+// Written by whoever applies a command, consumed by whichever task writes
+// the PWM next (control loop or effects). armed is published last.
+std::atomic<bool> armed{false};
+std::atomic<uint32_t> armedStartUs{0};
+std::atomic<uint32_t> armedAppliedUs{0};
+std::atomic<uint8_t> armedSource{0};
+
+}  // namespace
+
+void Histogram::record(uint32_t us) {
+    int bucket = 0;
+    while (bucket < BUCKETS - 1 && us > BUCKET_BOUNDS[bucket]) {
+        bucket++;
+    }
+    buckets[bucket]++;
+    if (count == 0 || us < minUs) {
+        minUs = us;
+    }
+    if (us > maxUs) {
+        maxUs = us;
+    }
+    totalUs += us;
+    count++;
+}
+
+void record(Stage stage, uint32_t us) {
+    lock();
+    histograms[stage].record(us);
+    unlock();
+}
+
+void armOutput(Source source, uint32_t startUs, uint32_t appliedUs) {
+    armed.store(false, std::memory_order_relaxed);
+    armedStartUs.store(startUs, std::memory_order_relaxed);
+    armedAppliedUs.store(appliedUs, std::memory_order_relaxed);
+    armedSource.store(static_cast<uint8_t>(source), std::memory_order_relaxed);
+    armed.store(true, std::memory_order_release);
+}
+
+void outputWritten() {
+    if (!armed.load(std::memory_order_acquire)) {
+        return;
+    }
+    armed.store(false, std::memory_order_relaxed);
+
+    uint32_t writtenUs = now();
+    uint32_t startUs = armedStartUs.load(std::memory_order_relaxed);
+    uint32_t appliedUs = armedAppliedUs.load(std::memory_order_relaxed);
+    if (writtenUs - appliedUs > OUTPUT_TIMEOUT_US) {
+        lock();
+        expired++;
+        unlock();
+        return;
+    }
+
+    if (static_cast<Source>(armedSource.load(std::memory_order_relaxed)) == Source::WEB) {
+        record(WEB_TOTAL, writtenUs - startUs);
+    } else {
+        record(MQTT_OUTPUT, writtenUs - appliedUs);
+        record(MQTT_TOTAL, writtenUs - startUs);
+    }
+}
+
+Histogram histogram(Stage stage) {
+    lock();
+    Histogram copy = histograms[stage];
+    unlock();
+    return copy;
+}
+
+const char* stageName(Stage stage) {
+    return stage < STAGE_COUNT ? STAGE_NAMES[stage] : "unknown";
+}
+
+uint32_t getExpired() {
+    lock();
+    uint32_t count = expired;
+    unlock();
+    return count;
+}
+
+void reset() {
+    armed.store(false);
+    lock();
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        histograms[i] = Histogram();
+    }
+    expired = 0;
+    unlock();
+}
+
+size_t toJson(char* buffer, size_t size) {
+    size_t length = 0;
+    auto append = [&](const char* format, auto... args) {
+        if (length < size) {
+            int written = snprintf(buffer + length, size - length, format, args...);
+            length += written > 0 ? static_cast<size_t>(written) : 0;
+        }
+    };
+
+    append("{");
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        const Histogram h = histogram(static_cast<Stage>(i));
+        append("%s\"%s\":{\"count\":%lu,\"min\":%lu,\"avg\":%lu,\"max\":%lu,\"buckets\":[",
+               i ? "," : "", STAGE_NAMES[i], (unsigned long)h.count, (unsigned long)h.minUs,
+               (unsigned long)h.avgUs(), (unsigned long)h.maxUs);
+        for (int b = 0; b < BUCKETS; b++) {
+            append("%s%lu", b ? "," : "", (unsigned long)h.buckets[b]);
+        }
+        append("]}");
+    }
+    append(",\"bounds_us\":[");
+    for (int b = 0; b < BUCKETS - 1; b++) {
+        append("%s%lu", b ? "," : "", (unsigned long)BUCKET_BOUNDS[b]);
+    }
+    append("],\"expired\":%lu}", (unsigned long)getExpired());
+
+    return length < size ? length : 0;
+}
+
+}  // namespace LatencyTrace
@@ -0,0 +1,78 @@
+#ifndef LATENCY_TRACE_H
+#define LATENCY_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Hal.h"
+
+// End-to-end command latency, from a payload arriving to the first PWM write
+// it causes. Trace points are plain hal::nowUs() stamps; each stage feeds a
+// fixed-bucket histogram that can be read at runtime or dumped as JSON.
+//
+//   MQTT: mqttCallback -> parsed -> popped by the control loop -> PWM write
+//   Web:  /postRGB handler -> PWM write
+//
+// Only one command is traced to the PWM at a time: a newer command re-arms
+// the output trace, and one that never changes a duty (same color again)
+// expires after OUTPUT_TIMEOUT_US instead of matching a later write.
+// The PWM write is the latch that makes a duty visible, in TemporalDither.
+// Histograms are updated and copied out under a lock, so any task can
+// record or read them.
+namespace LatencyTrace {
+
+enum Stage : uint8_t {
+    MQTT_PARSE,     // Callback entry -> parsed (includes logging)
+    MQTT_QUEUE,     // Parsed -> picked up by the control loop
+    MQTT_OUTPUT,    // Picked up -> first PWM write (apply + fade/effect step)
+    MQTT_TOTAL,     // Callback entry -> first PWM write
+    WEB_TOTAL,      // /postRGB handler entry -> first PWM write
+    STAGE_COUNT,
+};
+
+enum class Source : uint8_t {
+    MQTT,
+    WEB,
+};
+
+// Upper bounds (us) of the histogram buckets; the last bucket catches the rest
+static constexpr int BUCKETS = 12;
+static constexpr uint32_t BUCKET_BOUNDS[BUCKETS - 1] = {
+    50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000
+};
+static constexpr uint32_t OUTPUT_TIMEOUT_US = 250000;
+
+struct Histogram {
+    uint32_t buckets[BUCKETS] = {0};
+    uint32_t count = 0;
+    uint32_t minUs = 0;
+    uint32_t maxUs = 0;
+    uint64_t totalUs = 0;
+
+    void record(uint32_t us);
+    uint32_t avgUs() const { return count ? static_cast<uint32_t>(totalUs / count) : 0; }
+};
+
+inline uint32_t now() { return static_cast<uint32_t>(hal::nowUs()); }
+
+void record(Stage stage, uint32_t us);
+
+// Call just before a command is applied; the next PWM write closes its
+// trace. Arm first - an instant color change writes from inside apply.
+void armOutput(Source source, uint32_t startUs, uint32_t appliedUs);
+
+// Called after each LEDC latch - a single load when nothing is armed
+void outputWritten();
+
+// A consistent copy of one stage
+Histogram histogram(Stage stage);
+const char* stageName(Stage stage);
+uint32_t getExpired();
+void reset();
+
+// {"mqtt_parse":{"count":..,"min":..,"avg":..,"max":..,"buckets":[..]},...}
+// Returns the length written, or 0 if the buffer was too small.
+size_t toJson(char* buffer, size_t size);
+
+}  // namespace LatencyTrace
+
+#endif
@@ -0,0 +1,31 @@
+#include "LedOutput.h"
+#include "Hal.h"
+
+bool LedOutputBase::begin(uint32_t frequency, uint8_t resolutionBits) {
+    bool ok = true;
+    for (int i = 0; i < count; i++) {
+        ok = hal::pwmSetup(pins[i].channel, frequency, resolutionBits) && ok;
+    }
+    for (int i = 0; i < count; i++) {
+        ok = hal::pwmAttachPin(pins[i].pin, pins[i].channel) && ok;
+        stage(i, 0);
+    }
+    latch();
+    return ok;
+}
+
+void LedOutputBase::stage(int index, uint32_t duty) {
+    if (index < 0 || index >= count) {
+        return;
+    }
+    hal::pwmStage(pins[index].channel, duty);
+    stagedMask |= 1u << pins[index].channel;
+}
+
+void LedOutputBase::latch() {
+    if (stagedMask == 0) {
+        return;
+    }
+    hal::pwmLatch(stagedMask);
+    stagedMask = 0;
+}
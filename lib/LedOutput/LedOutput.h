@@ -0,0 +1,95 @@
+#ifndef LED_OUTPUT_H
+#define LED_OUTPUT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+#ifdef ARDUINO
+#include <driver/ledc.h>
+#endif
+
+// One output: the GPIO an LED string is wired to and the LEDC channel that
+// drives it
+struct LedPin {
+    int pin;
+    int channel;
+};
+
+// PWM outputs addressed by index (for a lamp: the color order of its pin
+// map). Duties are staged per output and latched in one uninterrupted
+// burst, so a color change reaches every channel within at most one PWM
+// period of each other (see hal::pwmLatch). Not thread-safe:
+// stage and latch from one context (TemporalDither's tick once it runs).
+//
+// Holds the map by pointer; LedOutput<> below checks it at compile time
+// and is what firmware declares.
+class LedOutputBase {
+public:
+#ifdef ARDUINO
+    static constexpr int MAX_OUTPUTS = LEDC_CHANNEL_MAX;   // LEDC channels on this chip, 6 on the C3
+#else
+    static constexpr int MAX_OUTPUTS = 8;   // Fake PWM channels on host builds
+#endif
+
+private:
+    const LedPin* const pins;
+    const int count;
+    uint32_t stagedMask = 0;
+
+protected:
+    LedOutputBase(const LedPin* pins, int count) : pins(pins), count(count) {}
+
+public:
+    // Configures every channel on the shared PWM timer and turns it off.
+    // Returns false if the driver rejected any of them (the HAL logs which).
+    bool begin(uint32_t frequency, uint8_t resolutionBits);
+
+    void stage(int index, uint32_t duty);
+    // Applies every staged duty at once; no-op if nothing was staged
+    void latch();
+
+    int size() const { return count; }
+    int channel(int index) const { return pins[index].channel; }
+    int pin(int index) const { return pins[index].pin; }
+};
+
+namespace led_output_detail {
+
+template <size_t N>
+constexpr bool validMap(const LedPin (&pins)[N]) {
+    for (size_t i = 0; i < N; i++) {
+        if (pins[i].channel < 0 || pins[i].channel >= LedOutputBase::MAX_OUTPUTS || pins[i].pin < 0) {
+            return false;
+        }
+        for (size_t j = i + 1; j < N; j++) {
+            if (pins[i].channel == pins[j].channel || pins[i].pin == pins[j].pin) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+}  // namespace led_output_detail
+
+// N-channel output over a constexpr pin map, e.g.
+//
+//   constexpr LedPin RGBW_PINS[] = {{7, 0}, {6, 1}, {5, 2}, {4, 3}};
+//   LedOutput<RGBW_PINS> output;
+//
+// The map's order is the index order; physical wiring lives here rather
+// than in channel swaps in the code. Several lamps on one MCU are several
+// maps with disjoint channels.
+template <const auto& PINS>
+class LedOutput : public LedOutputBase {
+public:
+    static constexpr int CHANNELS = static_cast<int>(std::extent<std::remove_reference_t<decltype(PINS)>>::value);
+
+    static_assert(CHANNELS > 0 && CHANNELS <= MAX_OUTPUTS, "LedOutput: 1 to MAX_OUTPUTS channels");
+    static_assert(led_output_detail::validMap(PINS),
+                  "LedOutput: channels 0 to MAX_OUTPUTS - 1, no pin or channel used twice");
+
+    LedOutput() : LedOutputBase(PINS, CHANNELS) {}
+};
+
+#endif
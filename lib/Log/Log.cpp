@@ -0,0 +1,95 @@
+#include "Log.h"
+#include <stdarg.h>
+#include <stdio.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <freertos/ringbuf.h>
+#endif
+
+namespace Log {
+
+namespace {
+
+const char LEVEL_TAGS[] = {'-', 'E', 'W', 'I', 'D'};
+
+uint32_t written = 0;
+uint32_t dropped = 0;
+
+#ifdef ARDUINO
+RingbufHandle_t ring = nullptr;
+portMUX_TYPE counterLock = portMUX_INITIALIZER_UNLOCKED;
+
+void drainTask(void* arg) {
+    for (;;) {
+        size_t size = 0;
+        void* line = xRingbufferReceive(ring, &size, portMAX_DELAY);
+        if (line) {
+            Serial.write(static_cast<const uint8_t*>(line), size);
+            vRingbufferReturnItem(ring, line);
+        }
+    }
+}
+#endif
+
+}  // namespace
+
+bool begin(int priority) {
+#ifdef ARDUINO
+    // No-split ring: each line is stored and received whole
+    ring = xRingbufferCreate(BUFFER_BYTES, RINGBUF_TYPE_NOSPLIT);
+    if (!ring) {
+        return false;
+    }
+    if (xTaskCreate(drainTask, "log", 2048, nullptr, priority, nullptr) != pdPASS) {
+        vRingbufferDelete(ring);
+        ring = nullptr;
+        return false;
+    }
+#endif
+    return true;
+}
+
+void write(int level, const char* format, ...) {
+    char line[LINE_MAX];
+    int length = snprintf(line, sizeof(line), "[%c] ", LEVEL_TAGS[level]);
+
+    // Leave room for the newline; vsnprintf returns the untruncated length
+    int room = LINE_MAX - length - 1;
+    va_list args;
+    va_start(args, format);
+    int formatted = vsnprintf(line + length, room, format, args);
+    va_end(args);
+    if (formatted > 0) {
+        length += formatted < room ? formatted : room - 1;
+    }
+    line[length++] = '\n';
+
+#ifdef ARDUINO
+    if (!ring) {
+        Serial.write(reinterpret_cast<const uint8_t*>(line), length);
+        return;
+    }
+    bool queued = xRingbufferSend(ring, line, length, 0) == pdTRUE;
+    portENTER_CRITICAL(&counterLock);
+    if (queued) {
+        written++;
+    } else {
+        dropped++;
+    }
+    portEXIT_CRITICAL(&counterLock);
+#else
+    fwrite(line, 1, length, stdout);
+    written++;
+#endif
+}
+
+uint32_t getWritten() {
+    return written;
+}
+
+uint32_t getDropped() {
+    return dropped;
+}
+
+}  // namespace Log
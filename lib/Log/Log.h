@@ -0,0 +1,62 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <stdint.h>
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+// Set with -DLOG_LEVEL=<n> in platformio.ini. Messages above this level are
+// compiled out entirely - their arguments are never evaluated, but formats
+// are still type-checked and locals used only for logging stay "used".
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+// Formatted lines go into an in-RAM ring buffer and a low-priority task
+// writes them to Serial, so callers never wait on the UART/USB. When the
+// buffer is full the line is dropped and counted rather than blocking.
+// Before begin() (and on host builds) lines are written directly.
+namespace Log {
+
+static constexpr int LINE_MAX = 192;        // Longer lines are truncated
+static constexpr int BUFFER_BYTES = 4096;
+
+bool begin(int priority);
+
+// Appends the newline itself. Prefer the LOG_* macros.
+void write(int level, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+uint32_t getWritten();
+uint32_t getDropped();
+
+}  // namespace Log
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_E(...) Log::write(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_E(...) do { if (0) Log::write(LOG_LEVEL_ERROR, __VA_ARGS__); } while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_W(...) Log::write(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_W(...) do { if (0) Log::write(LOG_LEVEL_WARN, __VA_ARGS__); } while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_I(...) Log::write(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_I(...) do { if (0) Log::write(LOG_LEVEL_INFO, __VA_ARGS__); } while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_D(...) Log::write(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_D(...) do { if (0) Log::write(LOG_LEVEL_DEBUG, __VA_ARGS__); } while (0)
+#endif
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef LIGHT_COMMAND_H
+#define LIGHT_COMMAND_H
+
+#include <stdint.h>
+#include "EffectsEngine.h"
+#include "ColorPipeline.h"
+
+// A parsed Home Assistant light command, passed from the network task to
+// the control loop. Only the fields flagged in `fields` were present.
+struct LightCommand {
+    enum : uint8_t {
+        HAS_STATE = 1 << 0,
+        HAS_COLOR = 1 << 1,
+        HAS_BRIGHTNESS = 1 << 2,
+        HAS_EFFECT = 1 << 3,
+        HAS_COLOR_TEMP = 1 << 4,
+    };
+
+    uint8_t fields = 0;
+    bool on = false;
+    uint8_t red = 0;
+    uint8_t green = 0;
+    uint8_t blue = 0;
+    uint8_t brightness = 0;
+    uint16_t colorTempK = 0;    // Kelvin, converted from HA's mireds
+    Effect effect = Effect::NONE;
+    uint32_t transitionMs = 0;
+    uint32_t receivedUs = 0;    // hal::nowUs() when the payload arrived
+    uint32_t parsedUs = 0;      // ...and when it was queued for the control loop
+
+    bool has(uint8_t field) const { return (fields & field) != 0; }
+};
+
+// Light state as applied by the control loop, reported back to the network
+// task for publishing.
+struct LightState {
+    bool on = false;
+    ColorState color;           // Canonical color; brightness kept while off
+    Effect effect = Effect::NONE;
+};
+
+#endif
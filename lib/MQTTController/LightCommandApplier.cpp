@@ -0,0 +1,84 @@
+#include "LightCommandApplier.h"
+#include "Log.h"
+#include "ColorTemperature.h"
+
+LightState LightCommandApplier::apply(const LightCommand& command, uint32_t nowMs) {
+    if (command.has(LightCommand::HAS_STATE)) {
+        is_on = command.on;
+        LOG_D("MQTT: State set to %s", is_on ? "ON" : "OFF");
+    }
+    
+    Effect requested_effect = effectsEngine.getEffect();
+    if (command.has(LightCommand::HAS_EFFECT)) {
+        requested_effect = command.effect;
+        LOG_D("MQTT: Effect set to %s", EffectsEngine::effectName(requested_effect));
+    }
+    
+    if (command.has(LightCommand::HAS_COLOR)) {
+        color.rgb[0] = command.red;
+        color.rgb[1] = command.green;
+        color.rgb[2] = command.blue;
+        color.kelvin = 0;
+        LOG_D("MQTT: Color set to R=%d G=%d B=%d", command.red, command.green, command.blue);
+    } else if (command.has(LightCommand::HAS_COLOR_TEMP)) {
+        color.kelvin = static_cast<uint16_t>(cct::clampKelvin(command.colorTempK));
+        LOG_D("MQTT: Color temperature set to %u K", color.kelvin);
+    }
+    if (command.has(LightCommand::HAS_BRIGHTNESS)) {
+        color.brightness = command.brightness;
+        LOG_D("MQTT: Brightness set to %d", command.brightness);
+    }
+    
+    // Setting color, brightness or an effect turns the light on unless
+    // the command explicitly turned it off
+    if (!command.has(LightCommand::HAS_STATE) &&
+        (command.fields & (LightCommand::HAS_COLOR | LightCommand::HAS_COLOR_TEMP | LightCommand::HAS_BRIGHTNESS |
+                           LightCommand::HAS_EFFECT))) {
+        is_on = true;
+    }
+    
+    // Apply the changes to the LED controller, fading if a transition was given
+    if (is_on && requested_effect != Effect::NONE) {
+        // The effects task owns the LEDs; the HA color tints/scales it
+        uint8_t hue[COLOR_CHANNELS] = {color.rgb[0], color.rgb[1], color.rgb[2]};
+        if (color.kelvin != 0) {
+            cct::toColor8(color.kelvin, 0, 255, hue);
+        }
+        fadeEngine.cancel();
+        effectsEngine.setBaseColor(hue[0], hue[1], hue[2], color.brightness);
+        if (requested_effect != effectsEngine.getEffect()) {
+            effectsEngine.setEffect(requested_effect, nowMs);
+        }
+        LOG_D("LEDs running effect: %s", EffectsEngine::effectName(requested_effect));
+    } else if (is_on) {
+        effectsEngine.stop();
+        fadeEngine.fadeTo(color_source::fromState(color), command.transitionMs, nowMs);
+        LOG_D("LEDs set to: R=%d G=%d B=%d %u K at %d (transition %lu ms)", color.rgb[0], color.rgb[1],
+                     color.rgb[2], color.kelvin, color.brightness, (unsigned long)command.transitionMs);
+    } else {
+        effectsEngine.stop();
+        fadeEngine.fadeTo(LinearColor(), command.transitionMs, nowMs);
+        LOG_D("LEDs turned OFF (transition %lu ms)", (unsigned long)command.transitionMs);
+    }
+    
+    return getState();
+}
+
+LightState LightCommandApplier::restore(const LightState& state, uint32_t nowMs) {
+    // Taken whole, so the rgb color under a temperature is still there
+    // when Home Assistant switches back to rgb
+    color = state.color;
+    LightCommand command;
+    command.fields = LightCommand::HAS_STATE | LightCommand::HAS_EFFECT;
+    command.on = state.on;
+    command.effect = state.effect;
+    return apply(command, nowMs);
+}
+
+LightState LightCommandApplier::getState() const {
+    LightState state;
+    state.on = is_on;
+    state.color = color;
+    state.effect = effectsEngine.getEffect();
+    return state;
+}
@@ -0,0 +1,32 @@
+#ifndef LIGHT_COMMAND_APPLIER_H
+#define LIGHT_COMMAND_APPLIER_H
+
+#include <stdint.h>
+#include "FadeEngine.h"
+#include "EffectsEngine.h"
+#include "LightCommand.h"
+
+// Control-loop side of Home Assistant commands: tracks the requested color
+// and on/off state, drives the fade and effects engines, and returns the
+// state to report back. No network code, so it runs on the host build too.
+class LightCommandApplier {
+private:
+    FadeEngine& fadeEngine;
+    EffectsEngine& effectsEngine;
+
+    // Canonical state; the duties are derived from it on every change and
+    // never written back, so repeated dimming cannot erode the color
+    ColorState color;   // Starts white at full brightness
+    bool is_on = false;
+
+public:
+    LightCommandApplier(FadeEngine& fader, EffectsEngine& effects)
+        : fadeEngine(fader), effectsEngine(effects) {}
+
+    LightState apply(const LightCommand& command, uint32_t nowMs);
+    // Boot: show a saved state at once, as if Home Assistant had sent it
+    LightState restore(const LightState& state, uint32_t nowMs);
+    LightState getState() const;
+};
+
+#endif
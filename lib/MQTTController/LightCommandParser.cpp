@@ -0,0 +1,79 @@
+#include "LightCommandParser.h"
+#include <string.h>
+#include "ColorPipeline.h"
+#include "Log.h"
+
+LightCommandParser::LightCommandParser() {
+    filter["state"] = true;
+    filter["brightness"] = true;
+    filter["transition"] = true;
+    filter["effect"] = true;
+    filter["color_temp"] = true;
+    JsonObject color = filter.createNestedObject("color");
+    color["r"] = true;
+    color["g"] = true;
+    color["b"] = true;
+    if (filter.overflowed()) {
+        LOG_E("LightCommandParser: filter overflowed %u bytes, commands will be rejected",
+              (unsigned)FILTER_CAPACITY);
+    }
+}
+
+DeserializationError LightCommandParser::parse(char* payload, size_t length, LightCommand& command) const {
+    if (filter.overflowed()) {
+        LOG_E("LightCommandParser: filter overflowed");
+        return DeserializationError::NoMemory;
+    }
+    StaticJsonDocument<DOCUMENT_CAPACITY> doc;
+    DeserializationError error = deserializeJson(doc, payload, length, DeserializationOption::Filter(filter));
+    if (error) {
+        return error;
+    }
+    if (doc.overflowed()) {
+        LOG_E("LightCommandParser: document overflowed %u bytes", (unsigned)DOCUMENT_CAPACITY);
+        return DeserializationError::NoMemory;
+    }
+
+    command = LightCommand();
+
+    // Optional fade time in seconds (HA "transition")
+    JsonVariantConst transition = doc["transition"];
+    if (!transition.isNull()) {
+        float seconds = transition.as<float>();
+        seconds = seconds < 0.0f ? 0.0f : (seconds > MAX_TRANSITION_S ? MAX_TRANSITION_S : seconds);
+        command.transitionMs = static_cast<uint32_t>(seconds * 1000.0f);
+    }
+
+    const char* state = doc["state"];
+    if (state) {
+        command.on = strcmp(state, "ON") == 0;
+        command.fields |= LightCommand::HAS_STATE;
+    }
+
+    // Unknown effect names are ignored, like unknown keys
+    const char* effect = doc["effect"];
+    if (effect && EffectsEngine::effectFromName(effect, command.effect)) {
+        command.fields |= LightCommand::HAS_EFFECT;
+    }
+
+    // RGB color takes priority over color temperature. HA sends the color
+    // at full brightness, so a brightness alongside either is kept too.
+    JsonObjectConst color = doc["color"];
+    if (!color.isNull() && color.containsKey("r") && color.containsKey("g") && color.containsKey("b")) {
+        command.red = clampColor8(color["r"].as<int>());
+        command.green = clampColor8(color["g"].as<int>());
+        command.blue = clampColor8(color["b"].as<int>());
+        command.fields |= LightCommand::HAS_COLOR;
+    } else if (doc.containsKey("color_temp")) {
+        // Color temperature in mireds
+        int mireds = doc["color_temp"].as<int>();
+        command.colorTempK = static_cast<uint16_t>(cct::miredsToKelvin(mireds < 0 ? 0 : mireds));
+        command.fields |= LightCommand::HAS_COLOR_TEMP;
+    }
+    if (doc.containsKey("brightness")) {
+        command.brightness = clampColor8(doc["brightness"].as<int>());
+        command.fields |= LightCommand::HAS_BRIGHTNESS;
+    }
+
+    return error;
+}
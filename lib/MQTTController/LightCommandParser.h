@@ -0,0 +1,36 @@
+#ifndef LIGHT_COMMAND_PARSER_H
+#define LIGHT_COMMAND_PARSER_H
+
+#include <stddef.h>
+#include <ArduinoJson.h>
+#include "LightCommand.h"
+
+// Parses Home Assistant JSON light commands without touching the heap.
+// The payload is deserialized in place (ArduinoJson zero-copy mode: strings
+// point into the buffer, which is modified) into a fixed-capacity document,
+// and a filter drops every key we do not act on before it takes up space.
+//
+// Capacities come from ArduinoJson's own slot macros, so they hold on the
+// 64-bit host builds (32-byte slots) as well as on the ESP32 (16-byte).
+class LightCommandParser {
+public:
+    // Six top-level keys, one of them the three-key color object
+    static constexpr size_t FILTER_CAPACITY = JSON_OBJECT_SIZE(6) + JSON_OBJECT_SIZE(3);
+    // The same shape, plus room for strings should they ever be copied
+    // (a const payload); zero-copy parsing keeps them in the buffer
+    static constexpr size_t DOCUMENT_CAPACITY = FILTER_CAPACITY + 32;
+    static constexpr float MAX_TRANSITION_S = 60.0f;
+
+private:
+    StaticJsonDocument<FILTER_CAPACITY> filter;
+
+public:
+    LightCommandParser();
+
+    // payload need not be NUL-terminated and is clobbered by the parse.
+    // NoMemory if the filter or the document ran out of room, rather than
+    // a command with fields silently missing.
+    DeserializationError parse(char* payload, size_t length, LightCommand& command) const;
+};
+
+#endif
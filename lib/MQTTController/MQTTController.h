@@ -4,8 +4,23 @@
 #include <WiFi.h>
 #include <PubSubClient.h>
 #include <ArduinoJson.h>
+#include <atomic>
 #include "LEDController.h"
+#include "FadeEngine.h"
+#include "EffectsEngine.h"
+#include "LightCommand.h"
+#include "LightCommandParser.h"
+#include "LightCommandApplier.h"
+#include "ColorTemperature.h"
+#include "WifiCache.h"
+#include "SpscQueue.h"
+#include "LatestSlot.h"
+#include "StatePublisher.h"
+#include "Telemetry.h"
+#include "LatencyTrace.h"
+#include "Hal.h"
 #include "config.h"
+#include "Log.h"
 
 class MQTTController {
 private:
@@ -30,20 +45,108 @@ private:
     String state_topic;
     String availability_topic;
     String config_topic;
+    String telemetry_topic;
+    String latency_topic;
     
-    // State tracking
-    int current_red = 255;   // Start with white color
-    int current_green = 255;
-    int current_blue = 255;
-    bool is_on = false;
-    
-    unsigned long lastReconnectAttempt = 0;
     unsigned long lastHeartbeat = 0;
-    const unsigned long RECONNECT_INTERVAL = 5000;
     const unsigned long HEARTBEAT_INTERVAL = 30000;
+    LightCommandParser commandParser;
+    LightCommandApplier commandApplier;
+
+    // Connection state machine, stepped every NETWORK_POLL_MS. No step waits
+    // on the network; timeouts are checked against stateEnteredAt instead.
+    enum class ConnectionState : uint8_t {
+        IDLE,
+        WIFI_CONNECTING,
+        MQTT_CONNECTING,
+        ONLINE,
+        BACKOFF,
+    };
+    ConnectionState connectionState = ConnectionState::IDLE;
+    unsigned long stateEnteredAt = 0;
+    unsigned long retryAt = 0;
+    bool everOnline = false;                        // Since the last start()
+    const unsigned long WIFI_CONNECT_TIMEOUT = 15000;
+    const unsigned long BACKOFF_BASE = 1000;        // First retry delay
+    const unsigned long BACKOFF_MAX = 60000;
+    const int INITIAL_MQTT_ATTEMPTS = 2;            // Before falling back to RGB mode
+    const uint16_t MQTT_SOCKET_TIMEOUT_S = 2;
+
+    // WiFi join paths. FAST goes straight to the cached AP (DHCP as usual);
+    // a miss within FAST_CONNECT_TIMEOUT falls back to FULL (scan + DHCP).
+    // After stop() the association lingers so a quick mode toggle REUSEs it.
+    enum class WifiPath : uint8_t {
+        REUSED,
+        FAST,
+        FULL,
+    };
+    WifiCache wifiCache;
+    SettingsStore wifiStore{WifiCache::NVS_NAMESPACE, 2000, 30000};   // Network task only
+    bool wifiCacheLoaded = false;
+    WifiPath wifiPath = WifiPath::FULL;
+    unsigned long connectStartedAt = 0;
+    unsigned long wifiReleaseAt = 0;
+    bool wifiLingering = false;
+    uint32_t wifiAssociateMs = 0;                   // Last start() -> WiFi up
+    uint32_t mqttOnlineMs = 0;                      // Last start() -> MQTT online
+    uint32_t wifiPathCounts[3] = {0};               // Per WifiPath
+    uint32_t fastConnectFallbacks = 0;
+    const unsigned long FAST_CONNECT_TIMEOUT = 5000;   // Association plus DHCP
+    const unsigned long WIFI_LINGER_MS = 60000;
 
     int connectionAttempts = 0;
-    bool initialConnectionFailed = false;
+    uint32_t reconnectCount = 0;
+    std::atomic<bool> initialConnectionFailed{false};
+    
+    // Networking runs on its own task. The control loop only talks to it
+    // through these: a desired on/off flag, parsed commands in, and applied
+    // state back out. Each has exactly one producer and one consumer.
+    static constexpr uint32_t NETWORK_POLL_MS = 10;
+    std::atomic<bool> wantOnline{false};
+    bool online = false;                           // Network task only
+    SpscQueue<LightCommand, 8> commandQueue;       // network -> control
+    LatestSlot<LightState> stateSlot;              // control -> network, newest wins
+    StatePublisher statePublisher{STATE_PUBLISH_WINDOW_MS};  // Network task only
+    uint32_t droppedCommands = 0;
+    uint32_t supersededStates = 0;
+    
+    // Diagnostics: the control loop records into telemetry and hands over a
+    // snapshot per period; RSSI is sampled here on the network task
+    TelemetryCollector& telemetry;
+    SpscQueue<TelemetrySnapshot, 2> telemetryQueue;  // control -> network
+    MetricAggregate rssi;                            // Network task only
+    unsigned long lastRssiSample = 0;
+    const unsigned long RSSI_SAMPLE_INTERVAL = 1000;
+    
+    // Diagnostic sensors announced next to the light. Each reads one key of
+    // the telemetry payload, which also carries every min/avg/max.
+    struct TelemetrySensor {
+        const char* key;
+        const char* name;
+        const char* unit;
+        const char* device_class;
+        const char* state_class;
+    };
+    static constexpr TelemetrySensor TELEMETRY_SENSORS[] = {
+        {"loop_time_avg", "Loop Time", "\u00b5s", nullptr, "measurement"},
+        {"loop_time_max", "Loop Time Max", "\u00b5s", nullptr, "measurement"},
+        {"free_heap_min", "Free Heap", "B", "data_size", "measurement"},
+        {"min_free_heap", "Min Free Heap", "B", "data_size", "measurement"},
+        {"rssi_avg", "WiFi RSSI", "dBm", "signal_strength", "measurement"},
+        {"reconnects", "MQTT Reconnects", nullptr, nullptr, "total_increasing"},
+        {"command_latency_avg", "Command Latency", "\u00b5s", nullptr, "measurement"},
+        {"command_latency_max", "Command Latency Max", "\u00b5s", nullptr, "measurement"},
+        {"boot_to_light", "Boot To Light", "ms", "duration", "measurement"},
+        {"wifi_associate", "WiFi Associate Time", "ms", "duration", "measurement"},
+        {"mqtt_online", "Time To Online", "ms", "duration", "measurement"},
+    };
+    TaskHandle_t networkTaskHandle = nullptr;
+    
+    // Payload scratch for the publishers, kept off the 6 KB network task
+    // stack. Network task only; PubSubClient copies each payload out before
+    // the next publish reuses them.
+    StaticJsonDocument<1024> publishDoc;
+    char publishBuffer[1024];
     
     void setupTopics() {
         String base = "homeassistant/light/" + String(device_id);
@@ -51,10 +154,13 @@ private:
         state_topic = base + "/state";
         availability_topic = base + "/availability";
         config_topic = base + "/config";
+        telemetry_topic = "homeassistant/sensor/" + String(device_id) + "/telemetry";
+        latency_topic = "homeassistant/sensor/" + String(device_id) + "/latency";
     }
     
     void publishDiscoveryConfig() {
-        StaticJsonDocument<1024> doc; // Increased size for better safety
+        JsonDocument& doc = publishDoc;
+        doc.clear();
         
         doc["name"] = device_name;
         doc["unique_id"] = device_id;
@@ -64,10 +170,21 @@ private:
         doc["availability_topic"] = availability_topic;
         doc["schema"] = "json";
         doc["brightness"] = true;
-        doc.createNestedArray("supported_color_modes").add("rgb");
+        JsonArray modes = doc.createNestedArray("supported_color_modes");
+        modes.add("rgb");
+        modes.add("color_temp");
+        doc["min_mireds"] = cct::kelvinToMireds(CCT_MAX_K);
+        doc["max_mireds"] = cct::kelvinToMireds(CCT_MIN_K);
+        doc["effect"] = true;
+        JsonArray effects = doc.createNestedArray("effect_list");
+        for (int i = 0; i < EffectsEngine::EFFECT_COUNT; i++) {
+            effects.add(EffectsEngine::effectName(static_cast<Effect>(i)));
+        }
         doc["optimistic"] = false;
         doc["retain"] = true;
         doc["brightness_scale"] = 255;
+        // The JSON schema always offers "transition"; handleCommand honours it
+        // through the fade engine, so there is no separate flag to set here
         
         // Device info for proper grouping in HA
         JsonObject device = doc.createNestedObject("device");
@@ -83,296 +200,485 @@ private:
         String config_payload;
         serializeJson(doc, config_payload);
         
-        Serial.println("=== MQTT Discovery Config ===");
-        Serial.printf("Topic: %s\n", config_topic.c_str());
-        Serial.printf("Payload: %s\n", config_payload.c_str());
-        Serial.println("=============================");
+        LOG_D("=== MQTT Discovery Config ===");
+        LOG_D("Topic: %s", config_topic.c_str());
+        LOG_D("Payload: %s", config_payload.c_str());
+        LOG_D("=============================");
         
         bool result = mqttClient.publish(config_topic.c_str(), config_payload.c_str(), true);
-        Serial.printf("Discovery config published: %s\n", result ? "SUCCESS" : "FAILED");
+        LOG_I("Discovery config published: %s", result ? "SUCCESS" : "FAILED");
         
         if (!result) {
-            Serial.printf("MQTT client state: %d\n", mqttClient.state());
-            Serial.printf("MQTT buffer size might be too small for payload size: %d\n", config_payload.length());
+            LOG_E("MQTT client state: %d", mqttClient.state());
+            LOG_E("MQTT buffer size might be too small for payload size: %u", config_payload.length());
         }
     }
     
-    void publishState() {
-        StaticJsonDocument<256> doc;
-        
-        doc["state"] = is_on ? "ON" : "OFF";
-        doc["color_mode"] = "rgb"; // Tell HA we're in RGB mode
-        
-        if (is_on) {
-            // Calculate brightness as the maximum of the RGB values
-            int max_rgb = max(max(current_red, current_green), current_blue);
-            doc["brightness"] = map(max_rgb, 0, 2047, 0, 255);
+    void publishTelemetryDiscovery() {
+        int published = 0;
+        for (const TelemetrySensor& sensor : TELEMETRY_SENSORS) {
+            JsonDocument& doc = publishDoc;
+            doc.clear();
             
-            // Always include color information in RGB format
-            JsonObject color = doc.createNestedObject("color");
-            color["r"] = map(current_red, 0, 2047, 0, 255);
-            color["g"] = map(current_green, 0, 2047, 0, 255);
-            color["b"] = map(current_blue, 0, 2047, 0, 255);
-        } else {
-            // When off, still report brightness as 0 but include last color
-            doc["brightness"] = 0;
-            JsonObject color = doc.createNestedObject("color");
-            color["r"] = map(current_red, 0, 2047, 0, 255);
-            color["g"] = map(current_green, 0, 2047, 0, 255);
-            color["b"] = map(current_blue, 0, 2047, 0, 255);
+            doc["name"] = sensor.name;
+            doc["unique_id"] = String(device_id) + "_" + sensor.key;
+            doc["state_topic"] = telemetry_topic;
+            doc["value_template"] = String("{{ value_json.") + sensor.key + " }}";
+            doc["availability_topic"] = availability_topic;
+            doc["entity_category"] = "diagnostic";
+            doc["state_class"] = sensor.state_class;
+            if (sensor.unit) {
+                doc["unit_of_measurement"] = sensor.unit;
+            }
+            if (sensor.device_class) {
+                doc["device_class"] = sensor.device_class;
+            }
+            // Go unavailable if the lamp stops reporting
+            doc["expire_after"] = 3 * telemetry.getPublishPeriodMs() / 1000;
+            doc["device"]["identifiers"][0] = device_id;
+            
+            serializeJson(doc, publishBuffer, sizeof(publishBuffer));
+            String topic = "homeassistant/sensor/" + String(device_id) + "/" + sensor.key + "/config";
+            if (mqttClient.publish(topic.c_str(), publishBuffer, true)) {
+                published++;
+            }
         }
-        
-        String state_payload;
-        serializeJson(doc, state_payload);
-        
-        Serial.printf("Publishing state: %s\n", state_payload.c_str());
-        bool result = mqttClient.publish(state_topic.c_str(), state_payload.c_str(), true);
-        Serial.printf("State published: %s\n", result ? "SUCCESS" : "FAILED");
+        LOG_I("Telemetry discovery published: %d/%d sensors", published,
+              (int)(sizeof(TELEMETRY_SENSORS) / sizeof(TELEMETRY_SENSORS[0])));
     }
     
-    void handleCommand(String payload) {
-        StaticJsonDocument<256> doc;
-        DeserializationError error = deserializeJson(doc, payload);
-        
-        if (error) {
-            Serial.println("Failed to parse MQTT command");
-            return;
+    static void addAggregate(JsonDocument& doc, const char* name, const MetricAggregate& metric) {
+        char key[32];
+        snprintf(key, sizeof(key), "%s_min", name);
+        doc[key] = metric.min;
+        snprintf(key, sizeof(key), "%s_avg", name);
+        doc[key] = metric.avg();
+        snprintf(key, sizeof(key), "%s_max", name);
+        doc[key] = metric.max;
+    }
+    
+    // Aggregates with no samples in the period (e.g. no commands) report 0
+    static const char* wifiPathName(WifiPath path) {
+        switch (path) {
+        case WifiPath::REUSED: return "reused";
+        case WifiPath::FAST: return "fast";
+        case WifiPath::FULL:
+        default: return "full";
         }
+    }
+    
+    void publishTelemetry(const TelemetrySnapshot& snapshot) {
+        JsonDocument& doc = publishDoc;
+        doc.clear();
         
-        Serial.printf("Handling MQTT command: %s\n", payload.c_str());
+        addAggregate(doc, "loop_time", snapshot.loopTimeUs);
+        addAggregate(doc, "free_heap", snapshot.freeHeap);
+        addAggregate(doc, "command_latency", snapshot.commandLatencyUs);
+        addAggregate(doc, "rssi", rssi);
+        doc["commands"] = snapshot.commandLatencyUs.count;
+        doc["min_free_heap"] = snapshot.minFreeHeap;
+        doc["reconnects"] = reconnectCount;
+        doc["period_s"] = snapshot.periodMs / 1000;
+        doc["boot_to_light"] = snapshot.bootToLightMs;
+        doc["wifi_associate"] = wifiAssociateMs;
+        doc["mqtt_online"] = mqttOnlineMs;
+        doc["wifi_path"] = wifiPathName(wifiPath);
+        doc["wifi_fast"] = wifiPathCounts[static_cast<int>(WifiPath::FAST)];
+        doc["wifi_full"] = wifiPathCounts[static_cast<int>(WifiPath::FULL)];
+        doc["wifi_reused"] = wifiPathCounts[static_cast<int>(WifiPath::REUSED)];
+        doc["wifi_fast_fallbacks"] = fastConnectFallbacks;
+        // Least stack the network task has had free since boot, in bytes
+        doc["network_stack_free"] = uxTaskGetStackHighWaterMark(nullptr);
+        rssi.reset();
         
-        // Handle state command
-        if (doc.containsKey("state")) {
-            String state = doc["state"];
-            is_on = (state == "ON");
-            Serial.printf("MQTT: State set to %s\n", is_on ? "ON" : "OFF");
+        serializeJson(doc, publishBuffer, sizeof(publishBuffer));
+        LOG_D("Publishing telemetry: %s", publishBuffer);
+        if (!mqttClient.publish(telemetry_topic.c_str(), publishBuffer, false)) {
+            LOG_W("Telemetry publish failed");
         }
         
-        // Handle color mode (HA might send this)
-        if (doc.containsKey("color_mode")) {
-            String color_mode = doc["color_mode"];
-            Serial.printf("MQTT: Color mode: %s\n", color_mode.c_str());
-            // We only support RGB mode, so this is just for logging
+        // Cumulative since boot; not a discovered sensor, for offline analysis
+        if (!LatencyTrace::toJson(publishBuffer, sizeof(publishBuffer)) ||
+            !mqttClient.publish(latency_topic.c_str(), publishBuffer, false)) {
+            LOG_W("Latency histogram publish failed");
         }
+    }
+    
+    // fields selects what goes out (StatePublisher::FIELD_*). "state" is
+    // always included, since Home Assistant keys every update off it.
+    void publishState(const LightState& state, uint8_t fields, bool retained) {
+        StaticJsonDocument<256> doc;
         
-        // Handle RGB color - this takes priority over brightness
-        if (doc.containsKey("color")) {
-            JsonObject color = doc["color"].as<JsonObject>();
-            if (color.containsKey("r") && color.containsKey("g") && color.containsKey("b")) {
-                int r = constrain((int)color["r"], 0, 255);
-                int g = constrain((int)color["g"], 0, 255);
-                int b = constrain((int)color["b"], 0, 255);
-                
-                current_red = map(r, 0, 255, 0, 2047);
-                current_green = map(g, 0, 255, 0, 2047);
-                current_blue = map(b, 0, 255, 0, 2047);
-                
-                Serial.printf("MQTT: Color set to R=%d G=%d B=%d (PWM: %d,%d,%d)\n", 
-                             r, g, b, current_red, current_green, current_blue);
-                
-                // If setting color, automatically turn on if not explicitly off
-                if (!doc.containsKey("state")) {
-                    is_on = true;
-                }
-            }
+        doc["state"] = state.on ? "ON" : "OFF";
+        if (fields & StatePublisher::FIELD_EFFECT) {
+            doc["effect"] = EffectsEngine::effectName(state.effect);
         }
-        // Handle brightness (affects all channels proportionally)
-        else if (doc.containsKey("brightness")) {
-            int brightness = constrain((int)doc["brightness"], 0, 255);
-            
-            // If we have existing color ratios, maintain them
-            if (current_red > 0 || current_green > 0 || current_blue > 0) {
-                int max_current = max(max(current_red, current_green), current_blue);
-                if (max_current > 0) {
-                    float scale = map(brightness, 0, 255, 0, 2047) / (float)max_current;
-                    current_red = (int)(current_red * scale);
-                    current_green = (int)(current_green * scale);
-                    current_blue = (int)(current_blue * scale);
-                }
+        
+        if (fields & StatePublisher::FIELD_COLOR) {
+            // Tell HA which mode we're in; color_temp goes back in mireds
+            if (state.color.kelvin != 0) {
+                doc["color_mode"] = "color_temp";
+                doc["color_temp"] = cct::kelvinToMireds(state.color.kelvin);
             } else {
-                // No existing color, set to white at specified brightness
-                int pwm_val = map(brightness, 0, 255, 0, 2047);
-                current_red = current_green = current_blue = pwm_val;
+                doc["color_mode"] = "rgb";
             }
             
-            Serial.printf("MQTT: Brightness set to %d (PWM: %d,%d,%d)\n", 
-                         brightness, current_red, current_green, current_blue);
+            // The canonical brightness, or 0 when off
+            doc["brightness"] = state.on ? state.color.brightness : 0;
             
-            // If setting brightness, automatically turn on if not explicitly off
-            if (!doc.containsKey("state")) {
-                is_on = true;
-            }
+            // Always include the color at full brightness (last color when off)
+            JsonObject color = doc.createNestedObject("color");
+            color["r"] = state.color.rgb[0];
+            color["g"] = state.color.rgb[1];
+            color["b"] = state.color.rgb[2];
         }
         
-        // Apply the changes to the LED controller
-        if (is_on) {
-            ledController.setPWMDirectly(current_red, current_green, current_blue);
-            Serial.printf("LEDs set to: R=%d G=%d B=%d\n", current_red, current_green, current_blue);
-        } else {
-            ledController.setPWMDirectly(0, 0, 0);
-            Serial.println("LEDs turned OFF");
+        char state_payload[256];
+        serializeJson(doc, state_payload, sizeof(state_payload));
+        
+        LOG_D("Publishing state%s: %s", retained ? "" : " (diff)", state_payload);
+        bool result = mqttClient.publish(state_topic.c_str(), state_payload, retained);
+        if (!result) {
+            LOG_W("State publish failed");
         }
+    }
+    
+    void publishFullState() {
+        publishState(statePublisher.getLatest(), StatePublisher::FIELD_ALL, true);
+        statePublisher.fullPublished(millis());
+    }
+    
+    // Network task: turn a payload into a LightCommand for the control loop.
+    // Parsed in place from PubSubClient's buffer - no String, no heap.
+    void handleCommand(char* payload, unsigned int length, uint32_t receivedUs) {
+        // Log first: the parse rewrites the buffer in place
+        LOG_D("Handling MQTT command: %.*s", (int)length, payload);
         
-        // Publish updated state back to HA
-        publishState();
+        LightCommand command;
+        DeserializationError error = commandParser.parse(payload, length, command);
+        if (error) {
+            LOG_W("Failed to parse MQTT command: %s", error.c_str());
+            return;
+        }
+        command.receivedUs = receivedUs;
+        command.parsedUs = LatencyTrace::now();
+        LatencyTrace::record(LatencyTrace::MQTT_PARSE, command.parsedUs - receivedUs);
+        
+        if (!commandQueue.push(command)) {
+            droppedCommands++;
+            LOG_W("MQTT: Command queue full, command dropped");
+        }
+    }
+    
+    // Control loop: hand the applied state back to the network task for HA
+    void reportState(const LightState& state) {
+        // Overwrites a state the network task has not picked up yet; only
+        // the newest one matters to the publisher
+        if (stateSlot.store(state)) {
+            supersededStates++;
+        }
     }
     
     static void mqttCallback(char* topic, byte* payload, unsigned int length) {
+        uint32_t receivedUs = LatencyTrace::now();
+        
         // This is a static callback, so we need to access the instance
         // We'll store a static pointer to the current instance
-        String message;
-        for (unsigned int i = 0; i < length; i++) {
-            message += (char)payload[i];
-        }
-        
-        Serial.printf("MQTT message received on %s: %s\n", topic, message.c_str());
+        LOG_D("MQTT message received on %s (%u bytes)", topic, length);
         
         // Find the instance and call the handler
         if (current_instance) {
-            current_instance->handleCommand(message);
+            current_instance->handleCommand(reinterpret_cast<char*>(payload), length, receivedUs);
         }
     }
     
     static MQTTController* current_instance;
-
-public:
-    MQTTController(LEDController &controller) 
-        : mqttClient(wifiClient), ledController(controller) {
-        current_instance = this;
-        setupTopics();
+    
+    static void networkTask(void* arg) {
+        MQTTController* self = static_cast<MQTTController*>(arg);
+        for (;;) {
+            self->serviceNetwork();
+            vTaskDelay(pdMS_TO_TICKS(NETWORK_POLL_MS));
+        }
     }
     
-    void begin() {
-        Serial.println("Starting MQTT mode...");
-
-        connectionAttempts = 0;
-        initialConnectionFailed = false;
-
-        // Connect to WiFi
-        WiFi.mode(WIFI_STA);
-        WiFi.begin(wifi_ssid, wifi_password);
-
-        Serial.printf("Connecting to WiFi network: %s\n", wifi_ssid);
-        int attempts = 0;
-        while (WiFi.status() != WL_CONNECTED && attempts < 30) {
-            delay(500);
-            Serial.print(".");
-            attempts++;
+    void serviceNetwork() {
+        // Hand the newest reported state to the publisher
+        LightState state;
+        if (stateSlot.take(state)) {
+            statePublisher.submit(state, millis());
         }
-
-        if (WiFi.status() != WL_CONNECTED) {
-            Serial.println("\nFailed to connect to WiFi");
-            initialConnectionFailed = true;
+        
+        wifiStore.update(millis());
+        
+        bool want = wantOnline.load();
+        if (want && !online) {
+            online = true;
+            startConnecting();
+        } else if (!want && online) {
+            online = false;
+            disconnect();
+        }
+        
+        if (!online) {
+            releaseWifiIfIdle();
             return;
         }
+        update();
+        if (connectionState == ConnectionState::ONLINE) {
+            uint8_t fields = 0;
+            StatePublisher::Action action = statePublisher.poll(millis(), fields);
+            if (action != StatePublisher::Action::NONE) {
+                publishState(statePublisher.getLatest(), fields,
+                             action == StatePublisher::Action::PUBLISH_FULL);
+            }
+            
+            unsigned long now = millis();
+            if (now - lastRssiSample >= RSSI_SAMPLE_INTERVAL) {
+                lastRssiSample = now;
+                rssi.add(WiFi.RSSI());
+            }
+        }
+        
+        // Periods that end while offline are dropped, not queued up
+        TelemetrySnapshot snapshot;
+        while (telemetryQueue.pop(snapshot)) {
+            if (connectionState == ConnectionState::ONLINE) {
+                publishTelemetry(snapshot);
+            }
+        }
+    }
+    
+    void enterState(ConnectionState next) {
+        connectionState = next;
+        stateEnteredAt = millis();
+    }
+    
+    void startConnecting() {
+        LOG_I("Starting MQTT mode...");
 
-        Serial.println();
-        Serial.printf("Connected to WiFi. IP address: %s\n", WiFi.localIP().toString().c_str());
+        connectionAttempts = 0;
+        everOnline = false;
 
-        // Setup MQTT
-        Serial.printf("Connecting to MQTT broker: %s:%d\n", mqtt_server, mqtt_port);
         mqttClient.setServer(mqtt_server, mqtt_port);
         mqttClient.setCallback(mqttCallback);
         mqttClient.setBufferSize(1024); // Increase buffer size for larger payloads
+        mqttClient.setSocketTimeout(MQTT_SOCKET_TIMEOUT_S);
 
         // Debug topic information
-        Serial.println("=== MQTT Topics ===");
-        Serial.printf("Command: %s\n", command_topic.c_str());
-        Serial.printf("State: %s\n", state_topic.c_str());
-        Serial.printf("Availability: %s\n", availability_topic.c_str());
-        Serial.printf("Config: %s\n", config_topic.c_str());
-        Serial.println("==================");
+        LOG_D("=== MQTT Topics ===");
+        LOG_D("Command: %s", command_topic.c_str());
+        LOG_D("State: %s", state_topic.c_str());
+        LOG_D("Availability: %s", availability_topic.c_str());
+        LOG_D("Config: %s", config_topic.c_str());
+        LOG_D("==================");
 
-        // Initial connection attempts (2 attempts max)
-        for (int i = 0; i < 2 && !mqttClient.connected(); i++) {
-            reconnect();
-            if (!mqttClient.connected() && i < 1) {
-                delay(2000);
-            }
+        connectStartedAt = millis();
+        wifiAssociateMs = 0;
+        mqttOnlineMs = 0;
+        
+        // Still associated from a recent stop() - straight to the broker
+        if (WiFi.status() == WL_CONNECTED) {
+            wifiLingering = false;
+            wifiPath = WifiPath::REUSED;
+            LOG_I("WiFi still connected, reusing it");
+            enterState(ConnectionState::MQTT_CONNECTING);
+            return;
         }
-
-        if (!mqttClient.connected()) {
-            Serial.println("Failed to connect to MQTT after 2 attempts");
-            initialConnectionFailed = true;
+        
+        // Connect to WiFi - completion is polled in update()
+        WiFi.mode(WIFI_STA);
+        if (!wifiCacheLoaded) {
+            wifiCache.load(wifiStore);
+            wifiCacheLoaded = true;
+        }
+        if (wifiCache.valid()) {
+            beginFastConnect();
+        } else {
+            beginFullConnect();
         }
+        enterState(ConnectionState::WIFI_CONNECTING);
     }
     
-    void reconnect() {
-        if (WiFi.status() != WL_CONNECTED) {
-            Serial.println("WiFi disconnected, attempting reconnection...");
-            WiFi.reconnect();
+    // Known AP: no channel scan. The address still comes from DHCP, so a
+    // lease the router has since moved can never stick as a static IP.
+    void beginFastConnect() {
+        wifiPath = WifiPath::FAST;
+        // All-zero config keeps the interface on DHCP
+        WiFi.config(IPAddress(), IPAddress(), IPAddress());
+        WiFi.begin(wifi_ssid, wifi_password, wifiCache.channel, wifiCache.bssid, true);
+        LOG_I("Fast-connecting to WiFi network: %s (%02x:%02x:%02x:%02x:%02x:%02x, channel %u)", wifi_ssid,
+              wifiCache.bssid[0], wifiCache.bssid[1], wifiCache.bssid[2], wifiCache.bssid[3],
+              wifiCache.bssid[4], wifiCache.bssid[5], wifiCache.channel);
+    }
+    
+    void beginFullConnect() {
+        wifiPath = WifiPath::FULL;
+        // All-zero config puts the interface back on DHCP
+        WiFi.config(IPAddress(), IPAddress(), IPAddress());
+        WiFi.begin(wifi_ssid, wifi_password);
+        LOG_I("Connecting to WiFi network: %s", wifi_ssid);
+    }
+    
+    // Online: remember this AP for the next fast connect. The store only
+    // writes flash when it changed.
+    void updateWifiCache() {
+        const uint8_t* bssid = WiFi.BSSID();
+        if (!bssid) {
             return;
         }
+        WifiCache fresh;
+        fresh.version = WifiCache::VERSION;
+        fresh.channel = static_cast<uint8_t>(WiFi.channel());
+        memcpy(fresh.bssid, bssid, sizeof(fresh.bssid));
+        if (!fresh.sameAs(wifiCache)) {
+            wifiCache = fresh;
+            wifiCache.save(wifiStore);
+            LOG_D("WiFi cache updated (channel %u)", wifiCache.channel);
+        }
+    }
+    
+    // Exponential backoff with +/-25% jitter so a fleet of lamps does not
+    // hammer the broker in lockstep after it restarts
+    void scheduleRetry() {
+        int shift = min(connectionAttempts, 6);
+        unsigned long delayMs = min(BACKOFF_BASE << shift, BACKOFF_MAX);
+        long jitter = random(-(long)(delayMs / 4), (long)(delayMs / 4) + 1);
+        retryAt = millis() + delayMs + jitter;
+        connectionAttempts++;
+        LOG_I("Retrying in %lu ms", (unsigned long)(delayMs + jitter));
+        enterState(ConnectionState::BACKOFF);
+    }
+    
+    void failInitialConnection(const char* reason) {
+        LOG_E("%s", reason);
+        initialConnectionFailed = true;
+        enterState(ConnectionState::IDLE);
+    }
+    
+    // One non-blocking MQTT connect attempt (bounded by the socket timeout)
+    bool connectMqtt() {
+        LOG_I("Attempting MQTT connection...");
+        
+        String client_id = String(device_id) + "_" + String(random(0xffff), HEX);
+        LOG_D("Client ID: %s", client_id.c_str());
+        
+        bool connected;
+        if (strlen(mqtt_user) > 0) {
+            LOG_D("Connecting with credentials: %s", mqtt_user);
+            connected = mqttClient.connect(client_id.c_str(), mqtt_user, mqtt_password, 
+                                         availability_topic.c_str(), 1, true, "offline");
+        } else {
+            LOG_D("Connecting without credentials");
+            connected = mqttClient.connect(client_id.c_str(), availability_topic.c_str(), 
+                                         1, true, "offline");
+        }
         
-        if (!mqttClient.connected()) {
-            Serial.print("Attempting MQTT connection...");
-            
-            String client_id = String(device_id) + "_" + String(random(0xffff), HEX);
-            Serial.printf("Client ID: %s\n", client_id.c_str());
-            
-            bool connected;
-            if (strlen(mqtt_user) > 0) {
-                Serial.printf("Connecting with credentials: %s\n", mqtt_user);
-                connected = mqttClient.connect(client_id.c_str(), mqtt_user, mqtt_password, 
-                                             availability_topic.c_str(), 1, true, "offline");
-            } else {
-                Serial.println("Connecting without credentials");
-                connected = mqttClient.connect(client_id.c_str(), availability_topic.c_str(), 
-                                             1, true, "offline");
-            }
-            
-            if (connected) {
-                Serial.println("MQTT connected successfully!");
-                
-                // Publish availability
-                bool avail_result = mqttClient.publish(availability_topic.c_str(), "online", true);
-                Serial.printf("Availability published: %s\n", avail_result ? "SUCCESS" : "FAILED");
-                
-                // Subscribe to command topic
-                bool sub_result = mqttClient.subscribe(command_topic.c_str());
-                Serial.printf("Subscribed to commands: %s\n", sub_result ? "SUCCESS" : "FAILED");
-                
-                // Small delay before discovery config
-                delay(100);
-                
-                // Test basic publishing first
-                String test_topic = "homeassistant/test/" + String(device_id);
-                bool test_result = mqttClient.publish(test_topic.c_str(), "test_message", false);
-                Serial.printf("Test publish result: %s\n", test_result ? "SUCCESS" : "FAILED");
-                
-                // Publish discovery config
-                publishDiscoveryConfig();
-                
-                // Small delay before state
-                delay(100);
-                
-                // Publish initial state
-                publishState();
-                
-                Serial.println("MQTT setup complete - device should appear in HA");
-            } else {
-                Serial.printf("MQTT connection failed, rc=%d\n", mqttClient.state());
-                switch(mqttClient.state()) {
-                    case -4: Serial.println("Connection timeout"); break;
-                    case -3: Serial.println("Connection lost"); break;
-                    case -2: Serial.println("Connect failed"); break;
-                    case -1: Serial.println("Disconnected"); break;
-                    case 1: Serial.println("Bad protocol"); break;
-                    case 2: Serial.println("Bad client ID"); break;
-                    case 3: Serial.println("Unavailable"); break;
-                    case 4: Serial.println("Bad credentials"); break;
-                    case 5: Serial.println("Unauthorized"); break;
-                }
-                Serial.println("Retrying in 5 seconds");
+        if (!connected) {
+            LOG_W("MQTT connection failed, rc=%d", mqttClient.state());
+            switch(mqttClient.state()) {
+                case -4: LOG_W("Connection timeout"); break;
+                case -3: LOG_W("Connection lost"); break;
+                case -2: LOG_W("Connect failed"); break;
+                case -1: LOG_W("Disconnected"); break;
+                case 1: LOG_W("Bad protocol"); break;
+                case 2: LOG_W("Bad client ID"); break;
+                case 3: LOG_W("Unavailable"); break;
+                case 4: LOG_W("Bad credentials"); break;
+                case 5: LOG_W("Unauthorized"); break;
             }
+            return false;
         }
+        
+        LOG_I("MQTT connected successfully!");
+        
+        // Publish availability
+        bool avail_result = mqttClient.publish(availability_topic.c_str(), "online", true);
+        LOG_I("Availability published: %s", avail_result ? "SUCCESS" : "FAILED");
+        
+        // Subscribe to command topic
+        bool sub_result = mqttClient.subscribe(command_topic.c_str());
+        LOG_I("Subscribed to commands: %s", sub_result ? "SUCCESS" : "FAILED");
+        
+        // Test basic publishing first
+        String test_topic = "homeassistant/test/" + String(device_id);
+        bool test_result = mqttClient.publish(test_topic.c_str(), "test_message", false);
+        LOG_I("Test publish result: %s", test_result ? "SUCCESS" : "FAILED");
+        
+        // Publish discovery config, then initial state
+        publishDiscoveryConfig();
+        publishTelemetryDiscovery();
+        publishFullState();
+        
+        LOG_I("MQTT setup complete - device should appear in HA");
+        return true;
     }
     
     void update() {
         unsigned long now = millis();
+        bool wifiUp = WiFi.status() == WL_CONNECTED;
         
-        // Handle MQTT loop
-        if (mqttClient.connected()) {
+        switch (connectionState) {
+        case ConnectionState::IDLE:
+            break;
+            
+        case ConnectionState::WIFI_CONNECTING:
+            if (wifiUp) {
+                if (!everOnline && wifiAssociateMs == 0) {
+                    wifiAssociateMs = now - connectStartedAt;
+                }
+                LOG_I("Connected to WiFi (%s, %lu ms). IP address: %s", wifiPathName(wifiPath),
+                      (unsigned long)wifiAssociateMs, WiFi.localIP().toString().c_str());
+                LOG_I("Connecting to MQTT broker: %s:%d", mqtt_server, mqtt_port);
+                enterState(ConnectionState::MQTT_CONNECTING);
+            } else if (!everOnline && wifiPath == WifiPath::FAST && now - stateEnteredAt >= FAST_CONNECT_TIMEOUT) {
+                // AP moved or changed channel; forget it and scan
+                LOG_W("WiFi fast connect failed, falling back to a full scan");
+                fastConnectFallbacks++;
+                wifiCache.invalidate(wifiStore);
+                WiFi.disconnect();
+                beginFullConnect();
+                enterState(ConnectionState::WIFI_CONNECTING);
+            } else if (now - stateEnteredAt >= WIFI_CONNECT_TIMEOUT) {
+                if (!everOnline) {
+                    failInitialConnection("Failed to connect to WiFi");
+                } else {
+                    LOG_W("WiFi reconnect timed out");
+                    scheduleRetry();
+                }
+            }
+            break;
+            
+        case ConnectionState::MQTT_CONNECTING:
+            if (!wifiUp) {
+                enterState(ConnectionState::WIFI_CONNECTING);
+            } else if (connectMqtt()) {
+                if (everOnline) {
+                    reconnectCount++;
+                } else {
+                    mqttOnlineMs = now - connectStartedAt;
+                    wifiPathCounts[static_cast<int>(wifiPath)]++;
+                    LOG_I("Online %lu ms after start (WiFi %s, %lu ms)", (unsigned long)mqttOnlineMs,
+                          wifiPathName(wifiPath), (unsigned long)wifiAssociateMs);
+                }
+                updateWifiCache();
+                everOnline = true;
+                connectionAttempts = 0;
+                lastHeartbeat = now;
+                enterState(ConnectionState::ONLINE);
+            } else if (!everOnline && connectionAttempts + 1 >= INITIAL_MQTT_ATTEMPTS) {
+                failInitialConnection("Failed to connect to MQTT after 2 attempts");
+            } else {
+                scheduleRetry();
+            }
+            break;
+            
+        case ConnectionState::ONLINE:
+            if (!mqttClient.connected() || !wifiUp) {
+                LOG_W("%s", wifiUp ? "MQTT connection lost" : "WiFi disconnected");
+                scheduleRetry();
+                break;
+            }
             mqttClient.loop();
             
             // Send periodic heartbeat
@@ -380,23 +686,103 @@ public:
                 mqttClient.publish(availability_topic.c_str(), "online", true);
                 lastHeartbeat = now;
             }
-        } else {
-            // Attempt reconnection
-            if (now - lastReconnectAttempt >= RECONNECT_INTERVAL) {
-                lastReconnectAttempt = now;
-                reconnect();
+            break;
+            
+        case ConnectionState::BACKOFF:
+            if ((long)(now - retryAt) < 0) {
+                break;
+            }
+            if (wifiUp) {
+                enterState(ConnectionState::MQTT_CONNECTING);
+            } else {
+                LOG_W("WiFi disconnected, attempting reconnection...");
+                WiFi.reconnect();
+                enterState(ConnectionState::WIFI_CONNECTING);
             }
+            break;
         }
     }
     
-    void stop() {
+    // Drops the broker but keeps WiFi associated for WIFI_LINGER_MS, so a
+    // mode toggle back to MQTT skips the join entirely
+    void disconnect() {
         if (mqttClient.connected()) {
             mqttClient.publish(availability_topic.c_str(), "offline", true);
             mqttClient.disconnect();
         }
-        WiFi.disconnect();
-        Serial.println("MQTT controller stopped");
+        wifiLingering = true;
+        wifiReleaseAt = millis() + WIFI_LINGER_MS;
+        enterState(ConnectionState::IDLE);
+        LOG_I("MQTT controller stopped");
+    }
+    
+    void releaseWifiIfIdle() {
+        if (wifiLingering && (long)(millis() - wifiReleaseAt) >= 0) {
+            wifiLingering = false;
+            WiFi.disconnect();
+            LOG_I("WiFi released");
+        }
     }
+
+public:
+    MQTTController(LEDController &controller, FadeEngine &fader, EffectsEngine &effects,
+                   TelemetryCollector &telemetryCollector) 
+        : mqttClient(wifiClient), ledController(controller), commandApplier(fader, effects),
+          telemetry(telemetryCollector) {
+        current_instance = this;
+        setupTopics();
+    }
+    
+    // Starts the network task. Keep its priority at or below the control
+    // loop's so a slow broker can only ever use idle time.
+    bool beginTask(UBaseType_t priority = 1) {
+        if (xTaskCreate(networkTask, "network", 6144, this, priority, &networkTaskHandle) != pdPASS) {
+            LOG_E("MQTT: failed to create network task");
+            return false;
+        }
+        return true;
+    }
+    
+    // Control loop: ask the network task to bring WiFi/MQTT up or down
+    void start() {
+        initialConnectionFailed = false;
+        wantOnline = true;
+    }
+    
+    void stop() {
+        wantOnline = false;
+    }
+    
+    // Control loop: apply every command the network task has parsed
+    void applyPendingCommands() {
+        LightCommand command;
+        while (commandQueue.pop(command)) {
+            uint32_t appliedUs = LatencyTrace::now();
+            LatencyTrace::record(LatencyTrace::MQTT_QUEUE, appliedUs - command.parsedUs);
+            LatencyTrace::armOutput(LatencyTrace::Source::MQTT, command.receivedUs, appliedUs);
+            reportState(commandApplier.apply(command, millis()));
+            telemetry.recordCommandLatency(LatencyTrace::now() - command.receivedUs);
+        }
+    }
+    
+    // Control loop: show a saved state before the network is up; it is
+    // published like any other once the broker connects
+    void restoreState(const LightState& state) {
+        reportState(commandApplier.restore(state, millis()));
+    }
+    
+    LightState getLightState() const { return commandApplier.getState(); }
+    
+    // Control loop: hand a finished telemetry period to the network task
+    void reportTelemetry(const TelemetrySnapshot& snapshot) {
+        telemetryQueue.push(snapshot);
+    }
+    
+    uint32_t getReconnectCount() const { return reconnectCount; }
+    uint32_t getDroppedCommands() const { return droppedCommands; }
+    uint32_t getSupersededStates() const { return supersededStates; }
+    uint32_t getPublishedStates() const { return statePublisher.getPublishedCount(); }
+    uint32_t getSuppressedStates() const { return statePublisher.getSuppressedCount(); }
     
     bool isConnected() {
         return WiFi.status() == WL_CONNECTED && mqttClient.connected();
@@ -0,0 +1,124 @@
+#ifndef STATE_PUBLISHER_H
+#define STATE_PUBLISHER_H
+
+#include <stdint.h>
+#include "LightCommand.h"
+
+// Decides when, and how much of, the light state goes out to Home
+// Assistant. A change after a quiet spell is published in full (retained)
+// straight away. Changes that land inside the coalescing window after a
+// publish are merged and sent once the window closes, as a diff holding only
+// the changed fields. When the burst is over the final state is always
+// flushed in full and retained, so the broker never holds a stale snapshot.
+class StatePublisher {
+public:
+    enum : uint8_t {
+        FIELD_STATE = 1 << 0,
+        FIELD_COLOR = 1 << 1,   // color, brightness and color_mode
+        FIELD_EFFECT = 1 << 2,
+        FIELD_ALL = FIELD_STATE | FIELD_COLOR | FIELD_EFFECT,
+    };
+
+    enum class Action : uint8_t {
+        NONE,
+        PUBLISH_DIFF,   // Only the returned fields, not retained
+        PUBLISH_FULL,   // Every field, retained
+    };
+
+private:
+    uint32_t windowMs;
+    LightState latest;          // Newest state from the control loop
+    LightState sent;            // What Home Assistant last heard
+    bool dirty = false;         // latest differs from sent
+    bool coalesced = false;     // A change arrived inside the window
+    bool finalOwed = false;     // Diffs went out; a full retained flush is due
+    bool anySent = false;
+    uint32_t lastPublishMs = 0;
+    uint32_t publishedCount = 0;
+    uint32_t suppressedCount = 0;
+
+    static uint8_t diff(const LightState& a, const LightState& b) {
+        uint8_t fields = 0;
+        if (a.on != b.on) {
+            // Reported brightness depends on on/off, so resend the color too
+            fields |= FIELD_STATE | FIELD_COLOR;
+        }
+        if (a.color != b.color) {
+            fields |= FIELD_COLOR;
+        }
+        if (a.effect != b.effect) {
+            fields |= FIELD_EFFECT;
+        }
+        return fields;
+    }
+
+    bool windowOpen(uint32_t nowMs) const {
+        return anySent && nowMs - lastPublishMs < windowMs;
+    }
+
+    void markSent(uint32_t nowMs) {
+        sent = latest;
+        dirty = false;
+        coalesced = false;
+        anySent = true;
+        lastPublishMs = nowMs;
+        publishedCount++;
+    }
+
+public:
+    explicit StatePublisher(uint32_t windowMs) : windowMs(windowMs) {}
+
+    // Queue a state for publishing. Whatever was still pending is superseded.
+    // A submit counts as suppressed once, whether it folded into a pending
+    // publish or told Home Assistant nothing new.
+    void submit(const LightState& state, uint32_t nowMs) {
+        bool superseded = dirty;
+        latest = state;
+        dirty = diff(latest, sent) != 0;
+        if (superseded || !dirty) {
+            suppressedCount++;
+        }
+        if (dirty && windowOpen(nowMs)) {
+            coalesced = true;
+        }
+    }
+
+    // Call regularly while connected. On a publish action, send latest()
+    // with the fields returned in `fields`.
+    Action poll(uint32_t nowMs, uint8_t& fields) {
+        if (windowOpen(nowMs)) {
+            return Action::NONE;
+        }
+        if (dirty) {
+            if (coalesced || finalOwed) {
+                fields = diff(latest, sent) | FIELD_STATE;
+                finalOwed = true;
+                markSent(nowMs);
+                return Action::PUBLISH_DIFF;
+            }
+            fields = FIELD_ALL;
+            markSent(nowMs);
+            return Action::PUBLISH_FULL;
+        }
+        if (finalOwed) {
+            fields = FIELD_ALL;
+            finalOwed = false;
+            markSent(nowMs);
+            return Action::PUBLISH_FULL;
+        }
+        return Action::NONE;
+    }
+
+    // A full publish made outside poll(), e.g. right after (re)connecting
+    void fullPublished(uint32_t nowMs) {
+        finalOwed = false;
+        markSent(nowMs);
+    }
+
+    const LightState& getLatest() const { return latest; }
+    uint32_t getWindowMs() const { return windowMs; }
+    uint32_t getPublishedCount() const { return publishedCount; }
+    uint32_t getSuppressedCount() const { return suppressedCount; }
+};
+
+#endif
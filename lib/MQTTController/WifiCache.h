@@ -0,0 +1,57 @@
+#ifndef WIFI_CACHE_H
+#define WIFI_CACHE_H
+
+#include <stdint.h>
+#include <string.h>
+#include "Hal.h"
+#include "SettingsStore.h"
+
+// Where the lamp last got online: the access point (BSSID and channel).
+// Joining with it skips the channel scan. The address still comes from
+// DHCP every time - a cached lease would outlive the real one and turn into
+// a stale static IP that associates fine and never trips the fallback.
+// Kept in RTC memory (warm resets) and, through a SettingsStore on its own
+// namespace, in NVS (power cuts); the store only writes flash when the AP
+// actually changes. Network task only, store included.
+struct WifiCache {
+    static constexpr uint8_t VERSION = 1;
+    static constexpr const char* NVS_NAMESPACE = "wifi";
+    static constexpr const char* NVS_KEY = "cache";
+
+    uint8_t version = 0;
+    uint8_t channel = 0;
+    uint8_t bssid[6] = {0};
+
+    bool valid() const { return version == VERSION && channel != 0; }
+
+    bool sameAs(const WifiCache& other) const { return memcmp(this, &other, sizeof(WifiCache)) == 0; }
+
+    // RTC first, else NVS. Returns valid().
+    bool load(SettingsStore& store) {
+        if (hal::rtcLoad(hal::RTC_SLOT_WIFI, this, sizeof(WifiCache)) != sizeof(WifiCache) || !valid()) {
+            if (store.getBytes(NVS_KEY, this, sizeof(WifiCache)) != sizeof(WifiCache)) {
+                *this = WifiCache();
+            }
+        }
+        return valid();
+    }
+
+    void save(SettingsStore& store) {
+        version = VERSION;
+        hal::rtcStore(hal::RTC_SLOT_WIFI, this, sizeof(WifiCache));
+        store.putBytes(NVS_KEY, this, sizeof(WifiCache));
+    }
+
+    // After a failed fast connect, so the next attempt goes straight to a
+    // scan; flushed at once rather than left to the debounce
+    void invalidate(SettingsStore& store) {
+        *this = WifiCache();
+        hal::rtcStore(hal::RTC_SLOT_WIFI, this, sizeof(WifiCache));
+        store.putBytes(NVS_KEY, this, sizeof(WifiCache));
+        store.flush();
+    }
+};
+
+static_assert(sizeof(WifiCache) <= hal::RTC_SLOT_BYTES, "WifiCache must fit an RTC slot");
+
+#endif
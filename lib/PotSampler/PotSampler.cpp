@@ -0,0 +1,122 @@
+#include "PotSampler.h"
+#include "Log.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <driver/adc.h>
+#include <esp_adc_cal.h>
+
+static esp_adc_cal_characteristics_t adcChars;
+
+bool PotSampler::begin(int pin0, int pin1, int pin2) {
+    const int pins[POT_COUNT] = {pin0, pin1, pin2};
+    uint32_t channelMask = 0;
+    for (int i = 0; i < POT_COUNT; i++) {
+        int channel = digitalPinToAnalogChannel(pins[i]);
+        if (channel < 0 || channel >= ADC1_CHANNEL_MAX) {
+            LOG_E("PotSampler: GPIO%d is not an ADC1 pin", pins[i]);
+            return false;
+        }
+        channels[i] = channel;
+        channelMask |= BIT(channel);
+    }
+
+    adc_digi_init_config_t initConfig = {};
+    initConfig.max_store_buf_size = DMA_BLOCK_BYTES * 4;
+    initConfig.conv_num_each_intr = DMA_BLOCK_BYTES;
+    initConfig.adc1_chan_mask = channelMask;
+    initConfig.adc2_chan_mask = 0;
+    if (adc_digi_initialize(&initConfig) != ESP_OK) {
+        LOG_E("PotSampler: adc_digi_initialize failed");
+        return false;
+    }
+
+    // Same 2.5 dB attenuation the pots were read with via analogReadMilliVolts
+    adc_digi_pattern_config_t pattern[POT_COUNT] = {};
+    for (int i = 0; i < POT_COUNT; i++) {
+        pattern[i].atten = ADC_ATTEN_DB_2_5;
+        pattern[i].channel = channels[i];
+        pattern[i].unit = 0;  // ADC1
+        pattern[i].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+    }
+
+    adc_digi_configuration_t config = {};
+    config.conv_limit_en = false;
+    config.conv_limit_num = 250;
+    config.pattern_num = POT_COUNT;
+    config.adc_pattern = pattern;
+    config.sample_freq_hz = SAMPLE_RATE_HZ;
+    config.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+    config.format = ADC_DIGI_OUTPUT_FORMAT_TYPE2;
+    if (adc_digi_controller_configure(&config) != ESP_OK) {
+        LOG_E("PotSampler: adc_digi_controller_configure failed");
+        adc_digi_deinitialize();
+        return false;
+    }
+
+    esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTEN_DB_2_5, ADC_WIDTH_BIT_12, 0, &adcChars);
+
+    if (xTaskCreate(samplerTask, "pot_sampler", 3072, this, 3,
+                    reinterpret_cast<TaskHandle_t*>(&taskHandle)) != pdPASS) {
+        LOG_E("PotSampler: failed to create sampler task");
+        adc_digi_deinitialize();
+        return false;
+    }
+
+    adc_digi_start();
+    LOG_I("PotSampler started: %lu Hz, %lu-byte DMA blocks",
+          (unsigned long)SAMPLE_RATE_HZ, (unsigned long)DMA_BLOCK_BYTES);
+    return true;
+}
+
+void PotSampler::samplerTask(void* arg) {
+    PotSampler* self = static_cast<PotSampler*>(arg);
+    for (;;) {
+        self->drainDma();
+    }
+}
+
+void PotSampler::drainDma() {
+    static uint8_t block[DMA_BLOCK_BYTES];
+    uint32_t length = 0;
+
+    esp_err_t result = adc_digi_read_bytes(block, DMA_BLOCK_BYTES, &length, portMAX_DELAY);
+    if (result == ESP_ERR_INVALID_STATE) {
+        // Driver buffer overflowed; the data returned is still valid
+        dmaOverflows++;
+    } else if (result != ESP_OK) {
+        return;
+    }
+
+    uint32_t sums[POT_COUNT] = {0};
+    uint16_t counts[POT_COUNT] = {0};
+    for (uint32_t i = 0; i + sizeof(adc_digi_output_data_t) <= length; i += sizeof(adc_digi_output_data_t)) {
+        const adc_digi_output_data_t* sample = reinterpret_cast<const adc_digi_output_data_t*>(&block[i]);
+        if (sample->type2.unit != 0) {
+            continue;
+        }
+        for (int p = 0; p < POT_COUNT; p++) {
+            if (sample->type2.channel == channels[p]) {
+                sums[p] += sample->type2.data;
+                counts[p]++;
+                break;
+            }
+        }
+    }
+
+    PotFrame frame;
+    frame.samples = 0xFFFF;
+    for (int p = 0; p < POT_COUNT; p++) {
+        if (counts[p] == 0) {
+            return;  // Incomplete block, wait for the next one
+        }
+        uint32_t raw = sums[p] / counts[p];
+        frame.millivolts[p] = static_cast<uint16_t>(esp_adc_cal_raw_to_voltage(raw, &adcChars));
+        if (counts[p] < frame.samples) {
+            frame.samples = counts[p];
+        }
+    }
+    push(frame);
+}
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef POT_SAMPLER_H
+#define POT_SAMPLER_H
+
+#include <stdint.h>
+#include "SpscQueue.h"
+
+static constexpr int POT_COUNT = 3;
+
+// One block of DMA conversions, already averaged per pot and converted to mV.
+struct PotFrame {
+    uint16_t millivolts[POT_COUNT];
+    uint16_t samples;  // Conversions folded into this frame (per pot, minimum)
+};
+
+// Background pot sampling. On the ESP32-C3 the ADC digital controller scans
+// the three pots continuously into a DMA buffer; a small task drains each DMA
+// block, averages it and pushes one PotFrame into the frame queue. The
+// control loop only ever pops finished frames, so reading the pots no longer
+// stalls it. Host builds leave begin() out and push frames themselves (see
+// RecordedPotSource).
+class PotSampler {
+public:
+    static constexpr int FRAME_QUEUE_DEPTH = 16;
+
+    // Total conversion rate across all pots and DMA block size. 12 kHz over
+    // three pots in 240-byte blocks (60 conversions) gives ~200 frames/s,
+    // each averaging 20 readings per pot.
+    static constexpr uint32_t SAMPLE_RATE_HZ = 12000;
+    static constexpr uint32_t DMA_BLOCK_BYTES = 240;
+
+private:
+    SpscQueue<PotFrame, FRAME_QUEUE_DEPTH> frames;
+    uint32_t droppedFrames = 0;   // Queue full, consumer fell behind
+    uint32_t dmaOverflows = 0;    // Driver reported its own buffer overflowed
+
+#ifdef ARDUINO
+    int channels[POT_COUNT] = {0};
+    void* taskHandle = nullptr;
+    static void samplerTask(void* arg);
+    void drainDma();
+#endif
+
+public:
+#ifdef ARDUINO
+    // Pins must be ADC1 capable (GPIO0-4 on the C3).
+    bool begin(int pin0, int pin1, int pin2);
+#endif
+
+    // Producer side - called from the sampler task or a host feeder.
+    void push(const PotFrame& frame) {
+        if (!frames.push(frame)) {
+            droppedFrames++;
+        }
+    }
+
+    // Consumer side - called from the control loop.
+    bool pop(PotFrame& frame) { return frames.pop(frame); }
+    int pending() const { return static_cast<int>(frames.size()); }
+
+    uint32_t getDroppedFrames() const { return droppedFrames; }
+    uint32_t getDmaOverflows() const { return dmaOverflows; }
+};
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef RECORDED_POT_SOURCE_H
+#define RECORDED_POT_SOURCE_H
+
+#include <stddef.h>
+#include "PotSampler.h"
+
+// Replays a recorded stream of pot frames into a PotSampler through the
+// same queue the DMA task fills on hardware, so the control path and its
+// filters can be exercised off-device.
+class RecordedPotSource {
+private:
+    PotSampler& sampler;
+    const PotFrame* frames;
+    size_t count;
+    size_t position = 0;
+    bool loop;
+
+public:
+    RecordedPotSource(PotSampler& sampler, const PotFrame* frames, size_t count, bool loop = false)
+        : sampler(sampler), frames(frames), count(count), loop(loop) {}
+
+    // Push up to n frames. Returns how many were pushed.
+    size_t feed(size_t n = 1) {
+        size_t pushed = 0;
+        while (pushed < n && count > 0) {
+            if (position >= count) {
+                if (!loop) {
+                    break;
+                }
+                position = 0;
+            }
+            sampler.push(frames[position++]);
+            pushed++;
+        }
+        return pushed;
+    }
+
+    bool finished() const { return !loop && position >= count; }
+    void rewind() { position = 0; }
+};
+
+#endif
@@ -0,0 +1,111 @@
+#include "PowerGovernor.h"
+
+PowerGovernor::PowerGovernor(const PowerChannel (&channelModel)[COLOR_CHANNELS], uint32_t tau, float knee)
+    : tauMs(tau > 0 ? static_cast<float>(tau) : 1.0f),
+      kneeFraction(knee < 0.0f ? 0.0f : (knee > 1.0f ? 1.0f : knee)) {
+    for (int c = 0; c < COLOR_CHANNELS; c++) {
+        channels[c] = channelModel[c];
+        fullPowerMw += channels[c].currentMa * channels[c].forwardVoltage;
+    }
+    for (int c = 0; c < COLOR_CHANNELS; c++) {
+        powerPerDuty[c] = fullPowerMw > 0.0f ? channels[c].currentMa * channels[c].forwardVoltage / fullPowerMw / PWM_MAX
+                                             : 0.0f;
+    }
+}
+
+void PowerGovernor::setSustainedLimit(float limit) {
+    sustainedLimit = limit < 0.0f ? 0.0f : (limit > 1.0f ? 1.0f : limit);
+}
+
+void PowerGovernor::setPeakLimit(float limit) {
+    limit = limit < 0.0f ? 0.0f : (limit > 1.0f ? 1.0f : limit);
+    peakQ15.store(static_cast<uint32_t>(limit * SCALE_ONE));
+}
+
+bool PowerGovernor::limitPeak(const int duty[COLOR_CHANNELS]) {
+    uint32_t peak = peakQ15.load();
+    if (peak >= SCALE_ONE) {
+        return false;
+    }
+    float power = 0.0f;
+    for (int c = 0; c < COLOR_CHANNELS; c++) {
+        power += powerPerDuty[c] * clampDuty(duty[c]);
+    }
+    uint32_t current = scaleQ15.load();
+    if (power * current <= static_cast<float>(peak)) {
+        return false;
+    }
+    scaleQ15.store(static_cast<uint32_t>(peak / power));
+    return true;
+}
+
+// Full power below the knee, easing down to the sustained limit as the
+// model reaches it. At the limit allowed == heat, so a constant full-scale
+// request settles exactly on the sustained power.
+float PowerGovernor::allowedPower() const {
+    float knee = sustainedLimit * kneeFraction;
+    if (heat <= knee) {
+        return 1.0f;
+    }
+    if (heat >= sustainedLimit) {
+        return sustainedLimit;
+    }
+    return sustainedLimit + (1.0f - sustainedLimit) * (sustainedLimit - heat) / (sustainedLimit - knee);
+}
+
+bool PowerGovernor::update(const int duty[COLOR_CHANNELS], uint32_t nowMs) {
+    if (!started) {
+        lastUpdateMs = nowMs;
+        started = true;
+    }
+    uint32_t elapsedMs = nowMs - lastUpdateMs;
+    lastUpdateMs = nowMs;
+
+    requestedMa = 0.0f;
+    requestedPower = 0.0f;
+    for (int c = 0; c < COLOR_CHANNELS; c++) {
+        requestedMa += channels[c].currentMa * clampDuty(duty[c]) / PWM_MAX;
+        requestedPower += powerPerDuty[c] * clampDuty(duty[c]);
+    }
+
+    float allowed = allowedPower();
+    float peak = getPeakLimit();
+    if (allowed > peak) {
+        allowed = peak;
+    }
+    float scale = requestedPower > allowed ? allowed / requestedPower : 1.0f;
+
+    // Backward-Euler step of dT/dt = (P - T) / tau: stable for any elapsed
+    // time, so a late control tick cannot make the model overshoot
+    float delivered = requestedPower * scale;
+    heat += (delivered - heat) * elapsedMs / (tauMs + elapsedMs);
+
+    uint32_t q = scale >= 1.0f ? SCALE_ONE : static_cast<uint32_t>(scale * SCALE_ONE);
+    stats.updates++;
+    if (requestedMa > stats.peakCurrentMa) {
+        stats.peakCurrentMa = requestedMa;
+    }
+    if (q < SCALE_ONE) {
+        stats.throttledMs += elapsedMs;
+        if (scale < stats.minScale) {
+            stats.minScale = scale;
+        }
+    }
+
+    if (q == scaleQ15.load()) {
+        return false;
+    }
+    scaleQ15.store(q);
+    return true;
+}
+
+void PowerGovernor::resetStats() {
+    stats = PowerStats();
+}
+
+void PowerGovernor::reset() {
+    heat = 0.0f;
+    started = false;
+    scaleQ15.store(SCALE_ONE);
+    resetStats();
+}
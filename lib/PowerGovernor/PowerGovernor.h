@@ -0,0 +1,99 @@
+#ifndef POWER_GOVERNOR_H
+#define POWER_GOVERNOR_H
+
+#include <stdint.h>
+#include <atomic>
+#include "PwmTables.h"
+
+// Electrical model of one LED channel at full duty
+struct PowerChannel {
+    float currentMa;        // Drive current at PWM_MAX
+    float forwardVoltage;   // Vf at that current
+};
+
+struct PowerStats {
+    uint32_t updates = 0;
+    uint32_t throttledMs = 0;    // Time spent with the output scaled down
+    float peakCurrentMa = 0.0f;  // Highest requested (unscaled) current
+    float minScale = 1.0f;       // Deepest throttle since the last reset
+};
+
+// Thermal budget for the LEDs and driver. Instead of capping every write at
+// a fixed fraction, the governor estimates the electrical power of the
+// requested duties and integrates it through a first-order thermal model
+// (time constant tauMs, normalised so 1.0 is full power held forever).
+//
+// The sustained limit is the power the heat sink can hold indefinitely.
+// While the model is below kneeFraction of it the output runs unscaled, so
+// short bursts get full brightness; between the knee and the limit the
+// allowed power ramps down towards the limit, where the model settles. All
+// channels share one scale, so throttling dims without shifting the hue.
+//
+// The peak limit is a hard ceiling on the instantaneous power on top of
+// the thermal model, for when bursts are not wanted (locked mode). It is
+// checked on every latch through limitPeak(), not only on update(), so a
+// bright write cannot run above it until the next control tick.
+//
+// update() runs from the control loop; scale() is a multiply on the PWM
+// write path and may be called from any task.
+class PowerGovernor {
+public:
+    static constexpr int SCALE_SHIFT = 15;
+    static constexpr uint32_t SCALE_ONE = 1u << SCALE_SHIFT;
+
+private:
+    PowerChannel channels[COLOR_CHANNELS];
+    float powerPerDuty[COLOR_CHANNELS] = {0};   // Fraction of full power per 11-bit duty step
+    const float tauMs;
+    const float kneeFraction;
+    float fullPowerMw = 0.0f;
+    float sustainedLimit = 1.0f;
+    float heat = 0.0f;            // Model temperature, as a fraction of full power
+    float requestedMa = 0.0f;
+    float requestedPower = 0.0f;  // Fraction of full power before scaling
+    uint32_t lastUpdateMs = 0;
+    bool started = false;
+    std::atomic<uint32_t> scaleQ15{SCALE_ONE};
+    std::atomic<uint32_t> peakQ15{SCALE_ONE};   // Peak power limit, Q15 of full power
+    PowerStats stats;
+
+    float allowedPower() const;
+
+public:
+    PowerGovernor(const PowerChannel (&channels)[COLOR_CHANNELS], uint32_t tauMs, float kneeFraction);
+
+    // Power (0..1 of all channels at full duty) that may be held indefinitely
+    void setSustainedLimit(float limit);
+    float getSustainedLimit() const { return sustainedLimit; }
+
+    // Instantaneous power (0..1) never exceeded; 1 turns the cap off
+    void setPeakLimit(float limit);
+    float getPeakLimit() const { return static_cast<float>(peakQ15.load()) / SCALE_ONE; }
+
+    // Steps the model with the duties currently requested (post-trim, before
+    // scaling). Returns true if the output scale changed and the channels
+    // need rewriting.
+    bool update(const int duty[COLOR_CHANNELS], uint32_t nowMs);
+
+    // Write path, before the duties are latched: lowers the scale at once if
+    // they would exceed the peak limit; update() lets it back up. Returns
+    // true if the scale changed and the channels need rescaling.
+    bool limitPeak(const int duty[COLOR_CHANNELS]);
+
+    uint16_t scale(int duty) const {
+        return static_cast<uint16_t>((static_cast<uint32_t>(duty) * scaleQ15.load()) >> SCALE_SHIFT);
+    }
+
+    float getScale() const { return static_cast<float>(scaleQ15.load()) / SCALE_ONE; }
+    float getHeat() const { return heat; }
+    float getRequestedPower() const { return requestedPower; }
+    float getRequestedCurrentMa() const { return requestedMa; }
+    float getCurrentMa() const { return requestedMa * getScale(); }
+    const PowerStats& getStats() const { return stats; }
+    void resetStats();
+
+    // Cold heat sink - for host runs that replay several scenarios
+    void reset();
+};
+
+#endif
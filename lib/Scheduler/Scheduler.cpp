@@ -0,0 +1,167 @@
+#include "Scheduler.h"
+#include "Log.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <esp_timer.h>
+#endif
+
+constexpr uint32_t RateGroup::JITTER_BOUNDS[];
+
+void RateGroup::recordJitter(uint32_t jitterUs) {
+    int bucket = 0;
+    while (bucket < JITTER_BUCKETS - 1 && jitterUs > JITTER_BOUNDS[bucket]) {
+        bucket++;
+    }
+    jitterHistogram[bucket]++;
+    if (jitterUs > maxJitterUs) {
+        maxJitterUs = jitterUs;
+    }
+}
+
+void RateGroup::resetStats() {
+    runs = 0;
+    overruns = 0;
+    lastRunUs = 0;
+    maxRunUs = 0;
+    maxJitterUs = 0;
+    maxLatencyUs = 0;
+    for (int i = 0; i < JITTER_BUCKETS; i++) {
+        jitterHistogram[i] = 0;
+    }
+}
+
+uint32_t Scheduler::gcd(uint32_t a, uint32_t b) {
+    while (b != 0) {
+        uint32_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+int Scheduler::addGroup(const char* name, uint32_t periodUs, RateGroupCallback callback) {
+    if (groupCount >= MAX_GROUPS || periodUs == 0 || callback == nullptr) {
+        return -1;
+    }
+
+    RateGroup& group = groups[groupCount];
+    group.name = name;
+    group.periodUs = periodUs;
+    group.callback = callback;
+    group.resetStats();
+
+    baseTickUs = (baseTickUs == 0) ? periodUs : gcd(baseTickUs, periodUs);
+    return groupCount++;
+}
+
+void Scheduler::start() {
+    uint64_t now = clock.nowMicros();
+    for (int i = 0; i < groupCount; i++) {
+        groups[i].nextDueUs = now;
+    }
+}
+
+int Scheduler::tick() {
+    int released = 0;
+    ticks++;
+
+    for (int i = 0; i < groupCount; i++) {
+        RateGroup& group = groups[i];
+        uint64_t start = clock.nowMicros();
+        if (start < group.nextDueUs) {
+            continue;
+        }
+
+        group.recordJitter(static_cast<uint32_t>(start - group.nextDueUs));
+        group.callback();
+        uint64_t finish = clock.nowMicros();
+
+        uint32_t runUs = static_cast<uint32_t>(finish - start);
+        group.runs++;
+        group.lastRunUs = runUs;
+        if (runUs > group.maxRunUs) {
+            group.maxRunUs = runUs;
+        }
+        uint32_t latencyUs = static_cast<uint32_t>(finish - group.nextDueUs);
+        if (latencyUs > group.maxLatencyUs) {
+            group.maxLatencyUs = latencyUs;
+        }
+        if (runUs > group.periodUs) {
+            group.overruns++;
+        }
+
+        // Stay on the absolute timeline; if whole periods were missed, count
+        // them and skip ahead instead of bursting to catch up.
+        group.nextDueUs += group.periodUs;
+        if (group.nextDueUs <= finish) {
+            uint64_t missed = (finish - group.nextDueUs) / group.periodUs + 1;
+            group.overruns += static_cast<uint32_t>(missed);
+            group.nextDueUs += missed * group.periodUs;
+        }
+        released++;
+    }
+    return released;
+}
+
+void Scheduler::resetStats() {
+    for (int i = 0; i < groupCount; i++) {
+        groups[i].resetStats();
+    }
+}
+
+#ifdef ARDUINO
+
+uint64_t EspTimerClock::nowMicros() {
+    return static_cast<uint64_t>(esp_timer_get_time());
+}
+
+void Scheduler::onTimer(void* arg) {
+    Scheduler* self = static_cast<Scheduler*>(arg);
+    xTaskNotifyGive(static_cast<TaskHandle_t>(self->taskToNotify));
+}
+
+bool Scheduler::begin() {
+    if (groupCount == 0) {
+        return false;
+    }
+
+    taskToNotify = xTaskGetCurrentTaskHandle();
+
+    esp_timer_create_args_t args = {};
+    args.callback = &Scheduler::onTimer;
+    args.arg = this;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "scheduler";
+
+    esp_timer_handle_t handle;
+    if (esp_timer_create(&args, &handle) != ESP_OK) {
+        LOG_E("Scheduler: failed to create tick timer");
+        return false;
+    }
+    timerHandle = handle;
+
+    start();
+    if (esp_timer_start_periodic(handle, baseTickUs) != ESP_OK) {
+        LOG_E("Scheduler: failed to start tick timer");
+        return false;
+    }
+
+    LOG_I("Scheduler started: %d groups, base tick %lu us", groupCount, (unsigned long)baseTickUs);
+    return true;
+}
+
+void Scheduler::end() {
+    if (timerHandle) {
+        esp_timer_handle_t handle = static_cast<esp_timer_handle_t>(timerHandle);
+        esp_timer_stop(handle);
+        esp_timer_delete(handle);
+        timerHandle = nullptr;
+    }
+}
+
+void Scheduler::waitForTick() {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+}
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+
+// Time source for the scheduler, in microseconds.
+class SchedulerClock {
+public:
+    virtual ~SchedulerClock() {}
+    virtual uint64_t nowMicros() = 0;
+};
+
+// Clock that only moves when told to - lets host builds step the scheduler
+// through exact timelines without hardware.
+class SimulatedClock : public SchedulerClock {
+private:
+    uint64_t now = 0;
+
+public:
+    uint64_t nowMicros() override { return now; }
+    void advance(uint64_t us) { now += us; }
+    void set(uint64_t us) { now = us; }
+};
+
+#ifdef ARDUINO
+// Backed by esp_timer_get_time() (64-bit, 1 us resolution).
+class EspTimerClock : public SchedulerClock {
+public:
+    uint64_t nowMicros() override;
+};
+#endif
+
+typedef void (*RateGroupCallback)();
+
+struct RateGroup {
+    // Upper bounds (us) of the release-jitter histogram buckets. The last
+    // bucket catches everything above the final bound.
+    static constexpr int JITTER_BUCKETS = 8;
+    static constexpr uint32_t JITTER_BOUNDS[JITTER_BUCKETS - 1] = {
+        50, 100, 250, 500, 1000, 2500, 5000
+    };
+
+    const char* name = nullptr;
+    uint32_t periodUs = 0;
+    RateGroupCallback callback = nullptr;
+    uint64_t nextDueUs = 0;
+
+    uint32_t runs = 0;
+    uint32_t overruns = 0;     // Ran longer than its period or missed a release
+    uint32_t lastRunUs = 0;
+    uint32_t maxRunUs = 0;
+    uint32_t maxJitterUs = 0;
+    uint32_t maxLatencyUs = 0;  // Worst release-to-completion (jitter + run)
+    uint32_t jitterHistogram[JITTER_BUCKETS] = {0};
+
+    void recordJitter(uint32_t jitterUs);
+    void resetStats();
+};
+
+// Fixed-rate scheduler with independent rate groups. Each group is released
+// on its own period, measured against an absolute timeline so late releases
+// do not accumulate drift. Groups are run in the order they were added, so
+// add the fastest/most time-critical ones first.
+//
+// On the ESP32 begin() starts a periodic esp_timer at the base tick that
+// wakes the calling task; waitForTick() blocks until then. Host builds skip
+// begin() and call tick() after advancing a SimulatedClock.
+class Scheduler {
+public:
+    static constexpr int MAX_GROUPS = 8;
+
+private:
+    SchedulerClock& clock;
+    RateGroup groups[MAX_GROUPS];
+    int groupCount = 0;
+    uint32_t baseTickUs = 0;
+    uint32_t ticks = 0;
+
+#ifdef ARDUINO
+    void* timerHandle = nullptr;
+    void* taskToNotify = nullptr;
+    static void onTimer(void* arg);
+#endif
+
+    static uint32_t gcd(uint32_t a, uint32_t b);
+
+public:
+    explicit Scheduler(SchedulerClock& clock) : clock(clock) {}
+
+    // Returns the group index, or -1 if the table is full or period is 0.
+    int addGroup(const char* name, uint32_t periodUs, RateGroupCallback callback);
+
+    // Base tick is the GCD of all group periods.
+    uint32_t getBaseTickUs() const { return baseTickUs; }
+
+    // Anchors every group's first release to the current time.
+    void start();
+
+#ifdef ARDUINO
+    // start() plus a periodic esp_timer that notifies the calling task.
+    bool begin();
+    void end();
+    void waitForTick();
+#endif
+
+    // Releases every group that is due. Returns the number of groups run.
+    int tick();
+
+    int getGroupCount() const { return groupCount; }
+    const RateGroup& getGroup(int index) const { return groups[index]; }
+    uint32_t getTickCount() const { return ticks; }
+    void resetStats();
+};
+
+#endif
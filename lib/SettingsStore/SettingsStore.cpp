@@ -0,0 +1,192 @@
+#include "SettingsStore.h"
+#include <string.h>
+#include "Log.h"
+
+SettingsStore::Entry* SettingsStore::find(const char* key) {
+    for (int i = 0; i < entryCount; i++) {
+        if (strcmp(entries[i].key, key) == 0) {
+            return &entries[i];
+        }
+    }
+    return nullptr;
+}
+
+SettingsStore::Entry* SettingsStore::add(const char* key, hal::NvsType type) {
+    if (entryCount >= MAX_KEYS) {
+        LOG_W("Settings: more than %d keys in '%s', '%s' goes straight to NVS", MAX_KEYS, ns, key);
+        return nullptr;
+    }
+    Entry& entry = entries[entryCount++];
+    entry.key = key;
+    entry.type = type;
+    return &entry;
+}
+
+// First access to a key: cache what flash holds (or the fallback if nothing)
+SettingsStore::Entry* SettingsStore::load(const char* key, hal::NvsType type, const void* fallback) {
+    Entry* entry = find(key);
+    if (entry) {
+        return entry;
+    }
+    entry = add(key, type);
+    if (!entry) {
+        return nullptr;
+    }
+
+    stats.reads++;
+    switch (type) {
+    case hal::NvsType::BOOL: {
+        uint8_t value = hal::nvsGetBool(ns, key, *static_cast<const uint8_t*>(fallback) != 0) ? 1 : 0;
+        memcpy(entry->value, &value, sizeof(value));
+        entry->length = sizeof(value);
+        break;
+    }
+    case hal::NvsType::UINT: {
+        uint32_t value = hal::nvsGetUInt(ns, key, *static_cast<const uint32_t*>(fallback));
+        memcpy(entry->value, &value, sizeof(value));
+        entry->length = sizeof(value);
+        break;
+    }
+    case hal::NvsType::BYTES:
+    default:
+        entry->length = static_cast<uint8_t>(hal::nvsGetBytes(ns, key, entry->value, sizeof(entry->value)));
+        break;
+    }
+
+    memcpy(entry->stored, entry->value, entry->length);
+    entry->storedLength = entry->length;
+    entry->storedKnown = true;
+    return entry;
+}
+
+void SettingsStore::put(const char* key, hal::NvsType type, const void* data, size_t size) {
+    stats.puts++;
+    Entry* entry = find(key);
+    if (!entry) {
+        entry = add(key, type);
+    }
+    if (!entry || size > MAX_VALUE_BYTES) {
+        hal::NvsWrite write = {key, type, data, size};
+        hal::nvsPutBatch(ns, &write, 1);
+        stats.keysWritten++;
+        return;
+    }
+
+    if (entry->length == size && memcmp(entry->value, data, size) == 0) {
+        stats.unchangedPuts++;
+        return;
+    }
+    memcpy(entry->value, data, size);
+    entry->length = static_cast<uint8_t>(size);
+
+    uint32_t now = hal::nowMs();
+    if (!entry->dirty) {
+        entry->dirty = true;
+        if (dirtyCount++ == 0) {
+            firstDirtyMs = now;
+        }
+    }
+    lastPutMs = now;
+}
+
+bool SettingsStore::getBool(const char* key, bool fallback) {
+    uint8_t value = fallback ? 1 : 0;
+    Entry* entry = load(key, hal::NvsType::BOOL, &value);
+    return entry ? entry->value[0] != 0 : hal::nvsGetBool(ns, key, fallback);
+}
+
+void SettingsStore::putBool(const char* key, bool value) {
+    uint8_t stored = value ? 1 : 0;
+    put(key, hal::NvsType::BOOL, &stored, sizeof(stored));
+}
+
+uint32_t SettingsStore::getUInt(const char* key, uint32_t fallback) {
+    Entry* entry = load(key, hal::NvsType::UINT, &fallback);
+    if (!entry) {
+        return hal::nvsGetUInt(ns, key, fallback);
+    }
+    uint32_t value;
+    memcpy(&value, entry->value, sizeof(value));
+    return value;
+}
+
+void SettingsStore::putUInt(const char* key, uint32_t value) {
+    put(key, hal::NvsType::UINT, &value, sizeof(value));
+}
+
+size_t SettingsStore::getBytes(const char* key, void* data, size_t size) {
+    Entry* entry = load(key, hal::NvsType::BYTES, nullptr);
+    if (!entry) {
+        return hal::nvsGetBytes(ns, key, data, size);
+    }
+    if (entry->length == 0 || entry->length > size) {
+        return 0;
+    }
+    memcpy(data, entry->value, entry->length);
+    return entry->length;
+}
+
+void SettingsStore::putBytes(const char* key, const void* data, size_t size) {
+    put(key, hal::NvsType::BYTES, data, size);
+}
+
+bool SettingsStore::update(uint32_t nowMs) {
+    if (dirtyCount == 0) {
+        return false;
+    }
+    if (nowMs - lastPutMs < settleMs && nowMs - firstDirtyMs < maxDelayMs) {
+        return false;
+    }
+    return flush();
+}
+
+bool SettingsStore::flush() {
+    if (dirtyCount == 0) {
+        return false;
+    }
+
+    hal::NvsWrite writes[MAX_KEYS];
+    Entry* written[MAX_KEYS];
+    int count = 0;
+    for (int i = 0; i < entryCount; i++) {
+        Entry& entry = entries[i];
+        if (!entry.dirty) {
+            continue;
+        }
+        entry.dirty = false;
+        if (entry.storedKnown && entry.storedLength == entry.length &&
+            memcmp(entry.stored, entry.value, entry.length) == 0) {
+            stats.keysReverted++;
+            continue;
+        }
+        writes[count] = {entry.key, entry.type, entry.value, entry.length};
+        written[count] = &entry;
+        count++;
+    }
+    dirtyCount = 0;
+    if (count == 0) {
+        return false;
+    }
+
+    stats.flushes++;
+    if (!hal::nvsPutBatch(ns, writes, count)) {
+        // Keep the keys dirty and retry once the settle time has passed again
+        stats.failedFlushes++;
+        for (int i = 0; i < count; i++) {
+            written[i]->dirty = true;
+        }
+        dirtyCount = count;
+        firstDirtyMs = lastPutMs = hal::nowMs();
+        LOG_W("Settings: committing %d keys to '%s' failed", count, ns);
+        return false;
+    }
+
+    for (int i = 0; i < count; i++) {
+        memcpy(written[i]->stored, written[i]->value, written[i]->length);
+        written[i]->storedLength = written[i]->length;
+        written[i]->storedKnown = true;
+    }
+    stats.keysWritten += count;
+    LOG_D("Settings: committed %d keys to '%s'", count, ns);
+    return true;
+}
@@ -0,0 +1,81 @@
+#ifndef SETTINGS_STORE_H
+#define SETTINGS_STORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Hal.h"
+
+struct SettingsStats {
+    uint32_t reads = 0;         // NVS reads (first get of each key)
+    uint32_t puts = 0;          // put*() calls
+    uint32_t unchangedPuts = 0; // put of the value already held, nothing marked
+    uint32_t flushes = 0;       // Batched commits
+    uint32_t keysWritten = 0;   // Keys written across all flushes
+    uint32_t keysReverted = 0;  // Dirty keys back at their flash value by flush time
+    uint32_t failedFlushes = 0;
+};
+
+// RAM cache over one NVS namespace. Gets hit flash once per key; puts only
+// update RAM and mark the key dirty. update() writes every dirty key in one
+// batch once puts have settled for settleMs (or at the latest maxDelayMs
+// after the first one), skipping keys that are back at the value already in
+// flash - a knob wiggled and returned costs nothing.
+//
+// Keys are stored by pointer: pass string literals, at most 15 characters
+// (the NVS limit). Not thread-safe; use from the control loop only.
+class SettingsStore {
+public:
+    static constexpr int MAX_KEYS = 16;
+    static constexpr size_t MAX_VALUE_BYTES = 32;
+
+private:
+    struct Entry {
+        const char* key = nullptr;
+        hal::NvsType type = hal::NvsType::BYTES;
+        uint8_t length = 0;
+        uint8_t value[MAX_VALUE_BYTES] = {0};
+        uint8_t storedLength = 0;
+        uint8_t stored[MAX_VALUE_BYTES] = {0};  // What flash holds, if known
+        bool storedKnown = false;
+        bool dirty = false;
+    };
+
+    const char* const ns;
+    const uint32_t settleMs;
+    const uint32_t maxDelayMs;
+    Entry entries[MAX_KEYS];
+    int entryCount = 0;
+    int dirtyCount = 0;
+    uint32_t firstDirtyMs = 0;
+    uint32_t lastPutMs = 0;
+    SettingsStats stats;
+
+    Entry* find(const char* key);
+    Entry* add(const char* key, hal::NvsType type);
+    Entry* load(const char* key, hal::NvsType type, const void* fallback);
+    void put(const char* key, hal::NvsType type, const void* data, size_t size);
+
+public:
+    SettingsStore(const char* ns, uint32_t settleMs, uint32_t maxDelayMs)
+        : ns(ns), settleMs(settleMs), maxDelayMs(maxDelayMs) {}
+
+    bool getBool(const char* key, bool fallback);
+    void putBool(const char* key, bool value);
+    uint32_t getUInt(const char* key, uint32_t fallback);
+    void putUInt(const char* key, uint32_t value);
+    // Returns the stored length, or 0 if the key is missing or larger than size
+    size_t getBytes(const char* key, void* data, size_t size);
+    void putBytes(const char* key, const void* data, size_t size);
+
+    // Control loop: flush if the debounce has expired. Returns true if it
+    // committed anything.
+    bool update(uint32_t nowMs);
+    // Write every dirty key now (e.g. before a restart)
+    bool flush();
+
+    bool isDirty() const { return dirtyCount > 0; }
+    const char* getNamespace() const { return ns; }
+    const SettingsStats& getStats() const { return stats; }
+};
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef LATEST_SLOT_H
+#define LATEST_SLOT_H
+
+#include <stdint.h>
+#include <atomic>
+#include <type_traits>
+
+// Single-value mailbox between one writer and one reader: a store replaces
+// whatever the reader has not taken yet, so the reader always gets the
+// newest value and never a backlog. A sequence counter brackets each copy
+// (odd while writing); a reader that saw it move retries, so it never
+// returns a half-written value. Plain atomic loads/stores only, like
+// SpscQueue.
+template <typename T>
+class LatestSlot {
+    static_assert(std::is_trivially_copyable<T>::value, "LatestSlot copies T while the writer may run");
+
+private:
+    T value{};
+    std::atomic<uint32_t> sequence{0};  // Owned by the writer
+    std::atomic<uint32_t> taken{0};     // Last sequence read, owned by the reader
+
+public:
+    // Returns true if it replaced a value the reader had not taken
+    bool store(const T& item) {
+        uint32_t s = sequence.load(std::memory_order_relaxed);
+        bool replaced = s != taken.load(std::memory_order_acquire);
+        sequence.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        value = item;
+        sequence.store(s + 2, std::memory_order_release);
+        return replaced;
+    }
+
+    // Returns false if nothing new was stored since the last take
+    bool take(T& out) {
+        for (;;) {
+            uint32_t before = sequence.load(std::memory_order_acquire);
+            if (before == taken.load(std::memory_order_relaxed)) {
+                return false;
+            }
+            if (before & 1) {
+                // Mid-store on another core; picked up on the next call
+                return false;
+            }
+            out = value;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == before) {
+                taken.store(before, std::memory_order_release);
+                return true;
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+// Fixed-capacity single-producer/single-consumer ring buffer. push() may only
+// be called from one task (or ISR) and pop() from one other task; neither
+// side locks or allocates. Only plain atomic loads/stores are used, so this
+// is safe on the ESP32-C3 which has no atomic read-modify-write instructions.
+template <typename T, size_t N>
+class SpscQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+private:
+    T items[N];
+    std::atomic<uint32_t> head{0};  // Next slot to write, owned by the producer
+    std::atomic<uint32_t> tail{0};  // Next slot to read, owned by the consumer
+
+public:
+    static constexpr size_t CAPACITY = N;
+
+    bool push(const T& item) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= N) {
+            return false;
+        }
+        items[h & (N - 1)] = item;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& out) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        out = items[t & (N - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return size() == 0; }
+};
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+
+// Running min/avg/max of one metric over a publish period. Adding a sample
+// is a couple of compares and an add, cheap enough for every loop tick.
+struct MetricAggregate {
+    int32_t min = 0;
+    int32_t max = 0;
+    int64_t sum = 0;
+    uint32_t count = 0;
+
+    void add(int32_t value) {
+        if (count == 0 || value < min) {
+            min = value;
+        }
+        if (count == 0 || value > max) {
+            max = value;
+        }
+        sum += value;
+        count++;
+    }
+
+    int32_t avg() const { return count ? static_cast<int32_t>(sum / count) : 0; }
+    void reset() { *this = MetricAggregate(); }
+};
+
+// What the control loop hands to the network task once per period
+struct TelemetrySnapshot {
+    MetricAggregate loopTimeUs;         // Time spent releasing rate groups per tick
+    MetricAggregate freeHeap;
+    MetricAggregate commandLatencyUs;   // MQTT receive -> applied in the control loop
+    uint32_t minFreeHeap = 0;           // Low-water mark since boot
+    uint32_t bootToLightMs = 0;         // Reset to restored light, 0 if nothing was restored
+    uint32_t periodMs = 0;
+};
+
+// Aggregates the control-loop metrics and cuts a snapshot every publish
+// period. Single-threaded: record and snapshot from the same task.
+class TelemetryCollector {
+private:
+    uint32_t publishPeriodMs;
+    uint32_t periodStartMs = 0;
+    TelemetrySnapshot current;
+
+public:
+    explicit TelemetryCollector(uint32_t publishPeriodMs) : publishPeriodMs(publishPeriodMs) {}
+
+    void recordLoopTime(uint32_t us) { current.loopTimeUs.add(static_cast<int32_t>(us)); }
+    void recordCommandLatency(uint32_t us) { current.commandLatencyUs.add(static_cast<int32_t>(us)); }
+    void recordHeap(uint32_t freeBytes, uint32_t minFreeBytes) {
+        current.freeHeap.add(static_cast<int32_t>(freeBytes));
+        current.minFreeHeap = minFreeBytes;
+    }
+    void recordBootToLight(uint32_t ms) { current.bootToLightMs = ms; }
+
+    bool due(uint32_t nowMs) const { return nowMs - periodStartMs >= publishPeriodMs; }
+
+    // Returns the period's aggregates and starts a new period
+    TelemetrySnapshot take(uint32_t nowMs) {
+        TelemetrySnapshot snapshot = current;
+        snapshot.periodMs = nowMs - periodStartMs;
+        current = TelemetrySnapshot();
+        current.minFreeHeap = snapshot.minFreeHeap;
+        current.bootToLightMs = snapshot.bootToLightMs;
+        periodStartMs = nowMs;
+        return snapshot;
+    }
+
+    uint32_t getPublishPeriodMs() const { return publishPeriodMs; }
+};
+
+#endif
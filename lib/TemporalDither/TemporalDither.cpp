@@ -0,0 +1,132 @@
+#include "TemporalDither.h"
+#include "Log.h"
+#include "LatencyTrace.h"
+
+#ifdef ARDUINO
+#include <esp_timer.h>
+#endif
+
+void TemporalDither::set(int index, uint16_t fine) {
+    if (index < 0 || index >= output.size()) {
+        return;
+    }
+    staged[index] = fine > PWM_FINE_MAX ? PWM_FINE_MAX : fine;
+}
+
+void TemporalDither::commit() {
+    publishing.store(true);
+    for (int index = 0; index < output.size(); index++) {
+        target[index] = staged[index];
+    }
+    publishing.store(false);
+
+    if (!ticking) {
+        for (int index = 0; index < output.size(); index++) {
+            uint16_t duty = target[index] >> DITHER_BITS;
+            if (duty != written[index]) {
+                written[index] = duty;
+                output.stage(index, duty);
+            }
+        }
+        output.latch();
+        LatencyTrace::outputWritten();
+        return;
+    }
+    if (idle.load()) {
+        wake();
+    }
+}
+
+void TemporalDither::tick() {
+    if (idle.load()) {
+        return;
+    }
+    stats.ticks++;
+    if (!publishing.load()) {
+        for (int index = 0; index < output.size(); index++) {
+            active[index] = target[index];
+        }
+    }
+
+    bool settled = true;
+    bool changed = false;
+    for (int index = 0; index < output.size(); index++) {
+        uint16_t duty = step(active[index], error[index]);
+        if (duty != written[index]) {
+            written[index] = duty;
+            output.stage(index, duty);
+            stats.writes++;
+            changed = true;
+        }
+        if ((active[index] & FRACTION_MASK) != 0) {
+            settled = false;
+        }
+    }
+    if (changed) {
+        output.latch();
+        LatencyTrace::outputWritten();
+        stats.latches++;
+    }
+
+    // Whole duties are written and stay put; nothing left to spread
+    if (settled) {
+        sleep();
+    }
+}
+
+#ifdef ARDUINO
+
+void TemporalDither::wake() {
+    idle.store(false);
+    stats.wakeups++;
+    // Fails harmlessly if a preempting commit() already started it
+    esp_timer_start_periodic(static_cast<esp_timer_handle_t>(timerHandle), tickUs);
+}
+
+void TemporalDither::sleep() {
+    idle.store(true);
+    esp_timer_stop(static_cast<esp_timer_handle_t>(timerHandle));
+}
+
+void TemporalDither::onTimer(void* arg) {
+    TemporalDither* self = static_cast<TemporalDither*>(arg);
+    int64_t start = esp_timer_get_time();
+    self->tick();
+    uint32_t elapsed = static_cast<uint32_t>(esp_timer_get_time() - start);
+    self->stats.busyUs += elapsed;
+    if (elapsed > self->stats.maxTickUs) {
+        self->stats.maxTickUs = elapsed;
+    }
+}
+
+bool TemporalDither::begin(uint32_t periodUs) {
+    esp_timer_create_args_t args = {};
+    args.callback = &TemporalDither::onTimer;
+    args.arg = this;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "dither";
+
+    esp_timer_handle_t handle;
+    if (esp_timer_create(&args, &handle) != ESP_OK) {
+        LOG_E("TemporalDither: failed to create tick timer");
+        return false;
+    }
+    timerHandle = handle;
+    tickUs = periodUs;
+    start();
+    LOG_I("Temporal dither: %d extra bits, tick %lu us", DITHER_BITS, (unsigned long)tickUs);
+    return true;
+}
+
+#else
+
+void TemporalDither::wake() {
+    idle.store(false);
+    stats.wakeups++;
+}
+
+void TemporalDither::sleep() {
+    idle.store(true);
+}
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef TEMPORAL_DITHER_H
+#define TEMPORAL_DITHER_H
+
+#include <stdint.h>
+#include <atomic>
+#include "PwmTables.h"
+#include "LedOutput.h"
+
+struct DitherStats {
+    uint32_t ticks = 0;    // Timer ticks that had work to do
+    uint32_t writes = 0;   // Channel duties staged from ticks
+    uint32_t latches = 0;  // Synchronized updates issued from ticks
+    uint32_t wakeups = 0;  // Idle -> running transitions
+    uint32_t maxTickUs = 0;   // Longest timer callback (ESP32 only)
+    uint64_t busyUs = 0;      // Time spent in timer callbacks (ESP32 only)
+};
+
+// First-order sigma-delta on top of the 11-bit LEDC duty. Callers set fine
+// duties (DITHER_BITS of fraction) per output and commit(); every tick each
+// output gets the integer part plus a carry from its error accumulator, so
+// the average over 2^DITHER_BITS ticks is the fine duty exactly. The PWM
+// frequency is untouched - only which of two adjacent duties each update
+// uses. Changed outputs are staged and latched in one burst once per tick.
+//
+// A fraction of k/16 repeats every 16 ticks at most, so the slowest ripple
+// is tickRate / 16 (250 Hz at the default 4 kHz) and it is one 11-bit step
+// deep. The timer only runs while some channel has a fraction to spread;
+// with whole duties a commit() lands on the next tick and the timer stops.
+//
+// On the ESP32 begin() ticks from an esp_timer. Its task outranks every
+// task that sets duties, and the C3 is single core, so a tick runs whole
+// between any two writer steps. commit() copies the staged duties under a
+// publishing flag; a tick that lands mid-copy keeps the previous set, so a
+// color is never latched half old, half new. Host builds call start() and
+// drive tick() themselves; before either, commit() latches the integer
+// parts straight away.
+//
+// The scheduler's base tick is dispatched by the same esp_timer task, so
+// a dither tick can hold its release back by up to one callback. The
+// callbacks are timed into maxTickUs and busyUs; compare maxTickUs with
+// the scheduler's jitter histogram in the DEBUG_SCHEDULER dump.
+class TemporalDither {
+public:
+    static constexpr int MAX_CHANNELS = LedOutputBase::MAX_OUTPUTS;
+    static constexpr int FRACTION_ONE = 1 << DITHER_BITS;
+    static constexpr int FRACTION_MASK = FRACTION_ONE - 1;
+
+private:
+    LedOutputBase& output;
+    uint16_t staged[MAX_CHANNELS] = {0};   // set() -> commit()
+    uint16_t target[MAX_CHANNELS] = {0};   // Last committed set
+    uint16_t active[MAX_CHANNELS] = {0};   // What tick() is spreading
+    std::atomic<bool> publishing{false};
+    uint16_t written[MAX_CHANNELS] = {0};
+    uint8_t error[MAX_CHANNELS] = {0};
+    bool ticking = false;           // tick() owns the writes
+    std::atomic<bool> idle{true};
+    DitherStats stats;
+
+#ifdef ARDUINO
+    void* timerHandle = nullptr;
+    uint32_t tickUs = 0;
+    static void onTimer(void* arg);
+#endif
+
+    void wake();
+    void sleep();
+
+public:
+    // One sigma-delta step: integer duty for this tick, error carried over
+    static uint16_t step(uint16_t fine, uint8_t& error) {
+        uint16_t duty = fine >> DITHER_BITS;
+        error += fine & FRACTION_MASK;
+        if (error >= FRACTION_ONE) {
+            error -= FRACTION_ONE;
+            duty++;
+        }
+        return duty;
+    }
+
+    explicit TemporalDither(LedOutputBase& output) : output(output) {}
+
+    // Hands the writes to tick() without a timer (host builds)
+    void start() { ticking = true; }
+
+#ifdef ARDUINO
+    // start() plus an esp_timer at tickUs, running only while needed
+    bool begin(uint32_t tickUs);
+#endif
+
+    // Fine duty for one output index, 0..PWM_FINE_MAX; nothing reaches the
+    // LEDs until commit()
+    void set(int index, uint16_t fine);
+    void commit();
+    void tick();
+
+    bool isIdle() const { return idle.load(); }
+    const DitherStats& getStats() const { return stats; }
+};
+
+#endif
@@ -0,0 +1,43 @@
+#include "WebAssets.h"
+#include <string.h>
+#include "WebAssetsData.h"
+
+namespace {
+
+const WebAsset ASSETS[] = {
+    WEB_ASSETS_TABLE
+};
+
+constexpr int ASSET_COUNT = sizeof(ASSETS) / sizeof(ASSETS[0]);
+
+}  // namespace
+
+namespace WebAssets {
+
+const WebAsset* find(const char* path) {
+    if (strcmp(path, "/") == 0) {
+        path = "/index.html";
+    }
+    for (int i = 0; i < ASSET_COUNT; i++) {
+        if (strcmp(path, ASSETS[i].path) == 0) {
+            return &ASSETS[i];
+        }
+    }
+    return nullptr;
+}
+
+int count() {
+    return ASSET_COUNT;
+}
+
+const WebAsset& at(int index) {
+    return ASSETS[index];
+}
+
+// Browsers send back exactly the ETag they were given, possibly in a list
+// or weak-prefixed by a proxy; a substring match covers all of those.
+bool matchesEtag(const WebAsset& asset, const char* ifNoneMatch) {
+    return ifNoneMatch != nullptr && strstr(ifNoneMatch, asset.etag) != nullptr;
+}
+
+}  // namespace WebAssets
@@ -0,0 +1,32 @@
+#ifndef WEB_ASSETS_H
+#define WEB_ASSETS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Static web UI files, gzipped at build time by scripts/embed_web_assets.py
+// and linked into flash (WebAssetsData.h, generated, not committed). Served
+// as-is with Content-Encoding: gzip; no filesystem involved.
+struct WebAsset {
+    const char* path;           // URL path, e.g. "/index.html"
+    const char* contentType;
+    const uint8_t* data;        // Gzipped bytes in flash
+    size_t length;
+    const char* etag;           // Quoted, hash of the gzipped bytes
+    bool immutable;             // Vendored file: cache for a year, else revalidate
+};
+
+namespace WebAssets {
+
+// Returns nullptr for unknown paths. "/" maps to "/index.html".
+const WebAsset* find(const char* path);
+
+int count();
+const WebAsset& at(int index);
+
+// True if an If-None-Match header value names this asset's ETag
+bool matchesEtag(const WebAsset& asset, const char* ifNoneMatch);
+
+}  // namespace WebAssets
+
+#endif
@@ -1,9 +1,12 @@
 #include <WiFi.h>
 #include <ESPAsyncWebServer.h>
 #include <AsyncTCP.h>
-#include <SPIFFS.h>
 #include "LEDController.h"
+#include "WebAssets.h"
+#include "Log.h"
+#include "LatencyTrace.h"
 #include <ESPmDNS.h>
+#include <atomic>
 
 class WiFiManager
 {
@@ -15,56 +18,145 @@ private:
     unsigned long lastUpdate = 0;
     const unsigned long MIN_UPDATE_INTERVAL = 5;
 
-    void handleRoot(AsyncWebServerRequest *request)
+    // /ws carries 3-byte binary frames (r, g, b) both ways and small JSON
+    // text messages for lock status. Browsers may send a frame per animation
+    // frame; only the newest one is applied per control tick. Nothing calls
+    // update() while WiFi mode is disabled in main.cpp, so none of this runs
+    // until that mode is back in the cycle.
+    static constexpr size_t COLOR_FRAME_BYTES = 3;
+    AsyncWebSocket ws;
+
+    // Latest-wins slot: written by the async_tcp task, drained by update().
+    // The top byte is a sequence number so the reader can tell a new frame
+    // from the one it last applied; stores only, no read-modify-write.
+    std::atomic<uint32_t> pendingFrame{0};
+    std::atomic<uint32_t> pendingFrameUs{0};
+    uint8_t receivedSequence = 0;
+    uint8_t appliedSequence = 0;
+    uint8_t currentColor[COLOR_FRAME_BYTES] = {0, 0, 0};
+    uint32_t framesReceived = 0;
+    uint32_t framesApplied = 0;
+
+    // /unlock and /reset write the settings store, which belongs to the
+    // control loop; the handlers post the request here and update() runs it
+    enum LockRequest : uint8_t
     {
-        Serial.println("Serving index.html");
-        request->send(SPIFFS, "/index.html", "text/html");
-    }
+        LOCK_NONE,
+        LOCK_UNLOCK,
+        LOCK_RESET,
+    };
+    std::atomic<uint8_t> pendingLock{LOCK_NONE};
 
-    void handleIroMin(AsyncWebServerRequest *request)
+    // Gzipped from flash; a matching If-None-Match gets an empty 304
+    void serveAsset(AsyncWebServerRequest *request, const WebAsset &asset)
     {
-        Serial.println("Serving iro.min.js");
-        AsyncWebServerResponse *response = request->beginResponse(SPIFFS, "/iro.min.js", "text/javascript");
-        response->addHeader("Cache-Control", "max-age=31536000");
-        response->addHeader("Expires", "Thu, 31 Dec 2037 23:59:59 GMT");
+        const char *ifNoneMatch = request->hasHeader("If-None-Match")
+                                      ? request->getHeader("If-None-Match")->value().c_str()
+                                      : nullptr;
+        AsyncWebServerResponse *response;
+        if (WebAssets::matchesEtag(asset, ifNoneMatch))
+        {
+            LOG_D("Not modified: %s", asset.path);
+            response = request->beginResponse(304);
+        }
+        else
+        {
+            LOG_D("Serving %s (%u bytes gzipped)", asset.path, (unsigned)asset.length);
+            response = request->beginResponse_P(200, asset.contentType, asset.data, asset.length);
+            response->addHeader("Content-Encoding", "gzip");
+        }
+        response->addHeader("ETag", asset.etag);
+        response->addHeader("Cache-Control", asset.immutable ? "public, max-age=31536000, immutable" : "no-cache");
         request->send(response);
     }
 
-    void handleIroScript(AsyncWebServerRequest *request)
+    const char *lockStatusJson()
     {
-        Serial.println("Serving iro_script.js");
-        request->send(SPIFFS, "/iro_script.js", "text/javascript");
+        return ledController.isUnlocked() ? "{\"unlocked\":true}" : "{\"unlocked\":false}";
     }
 
     void handleLockStatus(AsyncWebServerRequest *request)
     {
-        Serial.println("Lock status requested");
-        bool isUnlocked = ledController.isUnlocked();
-        Serial.printf("Current lock status: %s\n", isUnlocked ? "unlocked" : "locked");
-        String response = isUnlocked ? "{\"unlocked\":true}" : "{\"unlocked\":false}";
+        LOG_D("Lock status requested");
+        const char *response = lockStatusJson();
+        LOG_D("Current lock status: %s", response);
         request->send(200, "application/json", response);
     }
 
+    void handleSocketEvent(AsyncWebSocket *socket, AsyncWebSocketClient *client, AwsEventType type,
+                           void *arg, uint8_t *data, size_t len)
+    {
+        switch (type)
+        {
+        case WS_EVT_CONNECT:
+            LOG_D("[WS] Client %u connected", client->id());
+            client->text(lockStatusJson());
+            client->binary(currentColor, COLOR_FRAME_BYTES);
+            break;
+        case WS_EVT_DISCONNECT:
+            LOG_D("[WS] Client %u disconnected", client->id());
+            break;
+        case WS_EVT_DATA:
+        {
+            AwsFrameInfo *info = static_cast<AwsFrameInfo *>(arg);
+            bool whole = info->final && info->index == 0 && info->len == len;
+            if (!whole || info->opcode != WS_BINARY || len != COLOR_FRAME_BYTES)
+            {
+                LOG_D("[WS] Ignoring %u byte frame (opcode %u)", (unsigned)len, info->opcode);
+                break;
+            }
+            postColor(data[0], data[1], data[2], LatencyTrace::now());
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    // async_tcp task: hand a color to update(); only the newest is applied
+    void postColor(uint8_t r, uint8_t g, uint8_t b, uint32_t startUs)
+    {
+        receivedSequence++;
+        framesReceived++;
+        pendingFrameUs.store(startUs);
+        pendingFrame.store((static_cast<uint32_t>(receivedSequence) << 24) | (static_cast<uint32_t>(r) << 16) |
+                           (static_cast<uint32_t>(g) << 8) | b);
+    }
+
+    void pushLockStatus()
+    {
+        ws.textAll(lockStatusJson());
+    }
+
+    // The new status reaches open pages over /ws once update() has run it
     void handleUnlock(AsyncWebServerRequest *request)
     {
-        Serial.println("Unlock requested");
-        ledController.unlock();
-        ledController.checkAndUpdatePowerLimit();
-        Serial.println("Unlock complete");
+        LOG_I("Unlock requested");
+        pendingLock.store(LOCK_UNLOCK);
         request->send(200, "text/plain", "OK");
     }
 
     void handleReset(AsyncWebServerRequest *request)
     {
-        Serial.println("Reset requested");
-        ledController.resetToSafeMode();
-        ledController.checkAndUpdatePowerLimit();
-        Serial.println("Reset complete");
+        LOG_I("Reset requested");
+        pendingLock.store(LOCK_RESET);
         request->send(200, "text/plain", "OK");
     }
 
+    void handleLatency(AsyncWebServerRequest *request)
+    {
+        char json[896];
+        if (!LatencyTrace::toJson(json, sizeof(json)))
+        {
+            request->send(500, "text/plain", "Histogram too large");
+            return;
+        }
+        request->send(200, "application/json", json);
+    }
+
     void handleRGB(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total)
     {
+        uint32_t startUs = LatencyTrace::now();
         if (request->hasParam("r", true) && request->hasParam("g", true) && request->hasParam("b", true))
         {
             int r = request->getParam("r", true)->value().toInt();
@@ -72,38 +164,26 @@ private:
             int b = request->getParam("b", true)->value().toInt();
 
             // Debug print
-            Serial.printf("Received RGB request: r=%d, g=%d, b=%d\n", r, g, b);
-
-            int mappedR = map(constrain(r, 0, 255), 0, 255, 0, 2047);
-            int mappedG = map(constrain(g, 0, 255), 0, 255, 0, 2047);
-            int mappedB = map(constrain(b, 0, 255), 0, 255, 0, 2047);
-
-            Serial.printf("Mapped RGB values: r=%d, g=%d, b=%d\n", mappedR, mappedG, mappedB);
+            LOG_D("Received RGB request: r=%d, g=%d, b=%d", r, g, b);
 
-            ledController.setPWMDirectly(mappedR, mappedG, mappedB);
+            postColor(clampColor8(r), clampColor8(g), clampColor8(b), startUs);
             request->send(200, "text/plain", "OK");
         }
         else
         {
-            Serial.println("Invalid RGB parameters received");
+            LOG_W("Invalid RGB parameters received");
             request->send(400, "text/plain", "Bad Request");
         }
     }
 
 public:
-    WiFiManager(LEDController &controller) : server(80), ledController(controller) {}
+    WiFiManager(LEDController &controller) : server(80), ledController(controller), ws("/ws") {}
 
     void begin()
     {
-        if (!SPIFFS.begin(true))
-        {
-            Serial.println("SPIFFS Mount Failed");
-            return;
-        }
-
         // 1. Register WiFi event handler FIRST
         WiFi.onEvent([](WiFiEvent_t event, WiFiEventInfo_t info)
-                     { Serial.printf("[WiFi] Event: %d\n", event); });
+                     { LOG_D("[WiFi] Event: %d", event); });
 
         // Disable WiFi power save for better responsiveness
         WiFi.setSleep(false);
@@ -119,13 +199,13 @@ public:
         IPAddress apIP = WiFi.softAPIP();
         if (apIP == IPAddress(0, 0, 0, 0))
         {
-            Serial.println("AP Failed - Rebooting");
+            LOG_E("AP Failed - Rebooting");
             ESP.restart();
         }
 
         // mDNS setup after AP is confirmed working
         if (MDNS.begin("colorshadow")) {
-            Serial.println("MDNS responder started");
+            LOG_I("MDNS responder started");
             MDNS.addService("http", "tcp", 80);
         }
 
@@ -134,42 +214,45 @@ public:
         DefaultHeaders::Instance().addHeader("Access-Control-Allow-Methods", "GET, POST, PUT");
         DefaultHeaders::Instance().addHeader("Access-Control-Allow-Headers", "Content-Type");
 
-        server.on("/", HTTP_GET, std::bind(&WiFiManager::handleRoot, this, std::placeholders::_1));
-        server.on("/iro.min.js", HTTP_GET, std::bind(&WiFiManager::handleIroMin, this, std::placeholders::_1));
-        server.on("/iro_script.js", HTTP_GET, std::bind(&WiFiManager::handleIroScript, this, std::placeholders::_1));
+        server.on("/", HTTP_GET, [this](AsyncWebServerRequest *request)
+                  { serveAsset(request, *WebAssets::find("/")); });
+        for (int i = 0; i < WebAssets::count(); i++)
+        {
+            const WebAsset &asset = WebAssets::at(i);
+            server.on(asset.path, HTTP_GET, [this, &asset](AsyncWebServerRequest *request)
+                      { serveAsset(request, asset); });
+        }
         server.on("/lockStatus", HTTP_GET, std::bind(&WiFiManager::handleLockStatus, this, std::placeholders::_1));
         server.on("/unlock", HTTP_POST, std::bind(&WiFiManager::handleUnlock, this, std::placeholders::_1));
         server.on("/reset", HTTP_POST, std::bind(&WiFiManager::handleReset, this, std::placeholders::_1));
+        server.on("/latency", HTTP_GET, std::bind(&WiFiManager::handleLatency, this, std::placeholders::_1));
+
+        ws.onEvent(std::bind(&WiFiManager::handleSocketEvent, this, std::placeholders::_1, std::placeholders::_2,
+                             std::placeholders::_3, std::placeholders::_4, std::placeholders::_5,
+                             std::placeholders::_6));
+        server.addHandler(&ws);
 
         // In WiFiManager.h constructor
         server.on("/postRGB", HTTP_POST, [this](AsyncWebServerRequest *request)
                   {
+            uint32_t startUs = LatencyTrace::now();
+
             // Check for all 3 parameters first
             if(!request->hasParam("r", true) || !request->hasParam("g", true) || !request->hasParam("b", true)) {
                 request->send(400, "text/plain", "Missing parameters");
                 return;
             }
 
-            // Get and constrain values
-            int r = request->getParam("r", true)->value().toInt();
-            int g = request->getParam("g", true)->value().toInt();
-            int b = request->getParam("b", true)->value().toInt();
-            
-            r = constrain(r, 0, 255);
-            g = constrain(g, 0, 255);
-            b = constrain(b, 0, 255);
-
-            // Convert to 11-bit PWM range (0-2047)
-            int pwm_r = map(r, 0, 255, 0, 2047);
-            int pwm_g = map(g, 0, 255, 0, 2047);
-            int pwm_b = map(b, 0, 255, 0, 2047);
+            // Get and clamp values
+            uint8_t r = clampColor8(request->getParam("r", true)->value().toInt());
+            uint8_t g = clampColor8(request->getParam("g", true)->value().toInt());
+            uint8_t b = clampColor8(request->getParam("b", true)->value().toInt());
 
             // Debug output
-            Serial.printf("[WiFi] Received RGB: %d,%d,%d -> PWM: %d,%d,%d\n", 
-                        r, g, b, pwm_r, pwm_g, pwm_b);
+            LOG_D("[WiFi] Received RGB: %d,%d,%d", r, g, b);
 
-            // Set LEDs - account for physical pin swap
-            ledController.setPWMDirectly(pwm_r, pwm_g, pwm_b);
+            // Applied by update() - gamma, correction and trim happen in the color pipeline
+            postColor(r, g, b, startUs);
     
         request->send(200, "text/plain", "OK"); });
 
@@ -179,27 +262,66 @@ public:
         try
         {
             server.begin();
-            Serial.println("Async HTTP server started successfully");
+            LOG_I("Async HTTP server started successfully");
         }
         catch (...)
         {
-            Serial.println("Failed to start server - attempting restart");
+            LOG_E("Failed to start server - attempting restart");
             delay(1000);
             ESP.restart();
         }
     }
 
+    // Control loop: run a posted unlock/reset, then apply the newest color
+    // from /ws or /postRGB, if any, and echo it to every connected browser
+    // so other open pages follow along.
     void update()
     {
-        // Not needed with AsyncWebServer
+        uint8_t lock = pendingLock.load();
+        if (lock != LOCK_NONE)
+        {
+            pendingLock.store(LOCK_NONE);
+            if (lock == LOCK_UNLOCK)
+            {
+                ledController.unlock();
+            }
+            else
+            {
+                ledController.resetToSafeMode();
+            }
+            ledController.checkAndUpdatePowerLimit();
+            pushLockStatus();
+            LOG_I("%s complete", lock == LOCK_UNLOCK ? "Unlock" : "Reset");
+        }
+
+        uint32_t frame = pendingFrame.load();
+        uint8_t sequence = static_cast<uint8_t>(frame >> 24);
+        if (sequence != appliedSequence)
+        {
+            appliedSequence = sequence;
+            framesApplied++;
+            currentColor[0] = static_cast<uint8_t>(frame >> 16);
+            currentColor[1] = static_cast<uint8_t>(frame >> 8);
+            currentColor[2] = static_cast<uint8_t>(frame);
+
+            LatencyTrace::armOutput(LatencyTrace::Source::WEB, pendingFrameUs.load(), LatencyTrace::now());
+            ledController.setColor8(currentColor[0], currentColor[1], currentColor[2]);
+            ws.binaryAll(currentColor, COLOR_FRAME_BYTES);
+        }
+        ws.cleanupClients();
     }
 
+    // Frames received minus frames applied were superseded before a tick
+    uint32_t getFramesReceived() const { return framesReceived; }
+    uint32_t getFramesApplied() const { return framesApplied; }
+
     void stop()
     {
+        ws.closeAll();
         server.end();
         delay(100);
         WiFi.softAPdisconnect(true);
         delay(100);
-        Serial.println("WiFi and server stopped");
+        LOG_I("WiFi and server stopped");
     }
 };
\ No newline at end of file
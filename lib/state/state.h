@@ -1,14 +1,15 @@
 #ifndef STATE_H
 #define STATE_H
 
-#include <Arduino.h>
 #include "LEDController.h"
+#include "Hal.h"
+#include "Log.h"
 
 enum class OperationMode {
     RGB,
     MQTT,
+    LTT,        // Knobs set luminance, color temperature and tint
     // Temporarily disabled modes:
-    // LTT,
     // POWERCON,
     // WIFI,
     // OFF,
@@ -20,56 +21,66 @@ private:
     static constexpr int DEBOUNCE_TIME = 50;
     
     OperationMode currentMode;
+    OperationMode selectedMode;     // Last chosen with the button; fallbacks don't change it
     unsigned long lastButtonPress;
     bool buttonWasPressed;
     LEDController &ledController;
 
 public:
     StateHandler(LEDController &controller)
-        : currentMode(OperationMode::MQTT), lastButtonPress(0), buttonWasPressed(false), ledController(controller) {}
+        : currentMode(OperationMode::MQTT), selectedMode(OperationMode::MQTT), lastButtonPress(0), buttonWasPressed(false), ledController(controller) {}
 
-    void begin() {
-        currentMode = OperationMode::MQTT;
-        pinMode(BUTTON_PIN, INPUT);
-        Serial.println("Initial mode: MQTT");
+    void begin(OperationMode initialMode = OperationMode::MQTT) {
+        currentMode = initialMode;
+        selectedMode = initialMode;
+        hal::gpioInput(BUTTON_PIN);
+        LOG_I("Initial mode: %s", modeName(initialMode));
+    }
+
+    static const char* modeName(OperationMode mode) {
+        switch (mode) {
+            case OperationMode::RGB: return "RGB";
+            case OperationMode::LTT: return "LTT";
+            case OperationMode::MQTT:
+            default: return "MQTT";
+        }
     }
 
     OperationMode getCurrentMode() const {
         return currentMode;
     }
 
+    OperationMode getSelectedMode() const {
+        return selectedMode;
+    }
+
     void setMode(OperationMode mode) {
         currentMode = mode;
-        Serial.print("Mode set to: ");
-        switch(mode) {
-            case OperationMode::RGB: Serial.println("RGB"); break;
-//            case OperationMode::LTT: Serial.println("LTT"); break;
-//            case OperationMode::POWERCON: Serial.println("POWERCON"); break;
-            case OperationMode::MQTT: Serial.println("MQTT"); break;
-//            case OperationMode::WIFI: Serial.println("WIFI"); break;
-//            case OperationMode::OFF: Serial.println("OFF"); break;
-        }
+        LOG_I("Mode set to: %s", modeName(mode));
     }
 
     void update() {
-        bool buttonIsPressed = (digitalRead(BUTTON_PIN) == 0);
+        bool buttonIsPressed = (hal::gpioRead(BUTTON_PIN) == 0);
 
         if (buttonIsPressed && !buttonWasPressed) {
-            unsigned long now = millis();
+            unsigned long now = hal::nowMs();
             if (now - lastButtonPress >= DEBOUNCE_TIME) {
                 lastButtonPress = now;
 
-                // Toggle between RGB and MQTT only
+                // Cycle MQTT -> RGB -> LTT -> MQTT
                 switch (currentMode) {
                     case OperationMode::RGB:
+                        currentMode = OperationMode::LTT;
+                        break;
+                    case OperationMode::LTT:
                         currentMode = OperationMode::MQTT;
-                        Serial.println("Mode changed to: MQTT");
                         break;
                     case OperationMode::MQTT:
                         currentMode = OperationMode::RGB;
-                        Serial.println("Mode changed to: RGB");
                         break;
                 }
+                LOG_I("Mode changed to: %s", modeName(currentMode));
+                selectedMode = currentMode;
             }
         }
         buttonWasPressed = buttonIsPressed;
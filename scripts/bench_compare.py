@@ -0,0 +1,62 @@
+#!/usr/bin/env python3
+"""Compare two benchmark runs (JSON lines from src/bench).
+
+    python3 scripts/bench_compare.py before.jsonl after.jsonl [--threshold 10]
+
+Prints ns/op for every case in both runs and flags changes beyond the
+threshold (percent). Exits 1 if any case got slower by more than that, or
+started allocating.
+"""
+import argparse
+import json
+import sys
+
+
+def load(path):
+    results = {}
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if not line.startswith("{"):
+                continue  # Boot noise from the serial monitor
+            record = json.loads(line)
+            if "bench" in record:
+                results[record["bench"]] = record
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("before")
+    parser.add_argument("after")
+    parser.add_argument("--threshold", type=float, default=10.0)
+    args = parser.parse_args()
+
+    before = load(args.before)
+    after = load(args.after)
+    regressed = False
+
+    print(f"{'bench':34} {'before':>10} {'after':>10} {'change':>8}  allocs")
+    for name in sorted(set(before) | set(after)):
+        if name not in before or name not in after:
+            print(f"{name:34} {'only in ' + ('after' if name in after else 'before'):>30}")
+            continue
+        old, new = before[name], after[name]
+        change = (new["ns_per_op"] - old["ns_per_op"]) / old["ns_per_op"] * 100.0
+        flag = ""
+        if change > args.threshold:
+            flag = "  SLOWER"
+            regressed = True
+        elif change < -args.threshold:
+            flag = "  faster"
+        if new["allocs_per_op"] > old["allocs_per_op"]:
+            flag += "  ALLOCATES"
+            regressed = True
+        print(f"{name:34} {old['ns_per_op']:10.2f} {new['ns_per_op']:10.2f} {change:7.1f}%"
+              f"  {old['allocs_per_op']:.3f}->{new['allocs_per_op']:.3f}{flag}")
+
+    return 1 if regressed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
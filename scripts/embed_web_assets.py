@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+"""Gzip everything in data/ into lib/WebAssets/WebAssetsData.h.
+
+Runs as a PlatformIO pre-build script (see platformio.ini) or by hand:
+
+    python3 scripts/embed_web_assets.py
+
+Each file becomes a constexpr byte array served straight from flash with
+Content-Encoding: gzip. The ETag is a hash of the compressed bytes, so it
+only changes when the file does. Output is deterministic (gzip mtime 0)
+and only rewritten when its content changes, so builds stay incremental.
+"""
+import gzip
+import hashlib
+import os
+import re
+
+CONTENT_TYPES = {
+    ".html": "text/html",
+    ".js": "text/javascript",
+    ".css": "text/css",
+    ".json": "application/json",
+    ".svg": "image/svg+xml",
+    ".ico": "image/x-icon",
+}
+
+# Vendored, versioned files never change under the same name; everything
+# else must be revalidated (a cheap 304) so UI updates show up immediately.
+IMMUTABLE = re.compile(r"\.min\.js$")
+
+
+def project_dir():
+    try:
+        Import("env")  # noqa: F821 - provided by PlatformIO/SCons
+        return env["PROJECT_DIR"]  # noqa: F821
+    except NameError:
+        return os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+
+def identifier(name):
+    return re.sub(r"[^A-Za-z0-9]", "_", name).upper() + "_GZ"
+
+
+def render(assets):
+    lines = [
+        "// Generated by scripts/embed_web_assets.py from data/ - do not edit.",
+        "#ifndef WEB_ASSETS_DATA_H",
+        "#define WEB_ASSETS_DATA_H",
+        "",
+        "#include <stdint.h>",
+        "",
+        "namespace web_assets_data {",
+        "",
+    ]
+    for asset in assets:
+        lines.append(f"// {asset['name']}: {asset['size']} -> {len(asset['gz'])} bytes")
+        lines.append(f"constexpr uint8_t {asset['id']}[] = {{")
+        gz = asset["gz"]
+        for offset in range(0, len(gz), 16):
+            chunk = ", ".join(f"0x{b:02x}" for b in gz[offset:offset + 16])
+            lines.append(f"    {chunk},")
+        lines.append("};")
+        lines.append("")
+
+    lines.append("}  // namespace web_assets_data")
+    lines.append("")
+    lines.append("#define WEB_ASSETS_TABLE \\")
+    for asset in assets:
+        lines.append(
+            f"    {{\"/{asset['name']}\", \"{asset['type']}\", web_assets_data::{asset['id']}, "
+            f"sizeof(web_assets_data::{asset['id']}), \"\\\"{asset['etag']}\\\"\", "
+            f"{'true' if asset['immutable'] else 'false'}}}, \\"
+        )
+    lines.append("")
+    lines.append("#endif")
+    lines.append("")
+    return "\n".join(lines)
+
+
+def main():
+    root = project_dir()
+    data_dir = os.path.join(root, "data")
+    output = os.path.join(root, "lib", "WebAssets", "WebAssetsData.h")
+
+    assets = []
+    for name in sorted(os.listdir(data_dir)):
+        path = os.path.join(data_dir, name)
+        extension = os.path.splitext(name)[1]
+        if not os.path.isfile(path) or extension not in CONTENT_TYPES:
+            continue
+        with open(path, "rb") as f:
+            raw = f.read()
+        gz = gzip.compress(raw, compresslevel=9, mtime=0)
+        assets.append({
+            "name": name,
+            "id": identifier(name),
+            "type": CONTENT_TYPES[extension],
+            "size": len(raw),
+            "gz": gz,
+            "etag": hashlib.sha256(gz).hexdigest()[:16],
+            "immutable": bool(IMMUTABLE.search(name)),
+        })
+
+    text = render(assets)
+    try:
+        with open(output) as f:
+            if f.read() == text:
+                return
+    except FileNotFoundError:
+        pass
+    with open(output, "w") as f:
+        f.write(text)
+    total = sum(len(a["gz"]) for a in assets)
+    print(f"Embedded {len(assets)} web assets ({total} bytes gzipped) -> {output}")
+
+
+main()
@@ -0,0 +1,88 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include <chrono>
+#endif
+
+// Minimal microbenchmark harness. Each case runs a warm-up pass, then the
+// timed loop, and prints one JSON object per line so runs from different
+// commits can be diffed or fed to scripts/bench_compare.py. Timing comes from
+// the CPU cycle counter on the ESP32 and steady_clock on the host.
+namespace bench {
+
+// Heap allocations since boot, counted by the malloc wrappers in
+// bench_main.cpp (linked with -Wl,--wrap=malloc,...)
+extern volatile uint32_t allocations;
+
+// Keep the compiler from discarding a result it can prove unused
+template <typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "m"(value) : "memory");
+}
+
+#ifdef ARDUINO
+// 32-bit cycle counter: fine for timed loops under ~26 s at 160 MHz
+typedef uint32_t Ticks;
+static constexpr const char* TARGET = "esp32c3";
+inline Ticks nowTicks() { return ESP.getCycleCount(); }
+inline double ticksToNs(Ticks ticks) { return ticks * 1000.0 / ESP.getCpuFreqMHz(); }
+#else
+typedef uint64_t Ticks;
+static constexpr const char* TARGET = "native";
+inline Ticks nowTicks() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+inline double ticksToNs(Ticks ticks) { return static_cast<double>(ticks); }
+#endif
+
+inline void emit(const char* line) {
+#ifdef ARDUINO
+    Serial.println(line);
+#else
+    puts(line);
+#endif
+}
+
+// fn(i) is called `iterations` times with the iteration index
+template <typename Fn>
+void run(const char* name, uint32_t iterations, Fn fn) {
+    uint32_t warmup = iterations / 10 + 1;
+    for (uint32_t i = 0; i < warmup; i++) {
+        fn(i);
+    }
+
+    uint32_t allocationsBefore = allocations;
+    Ticks start = nowTicks();
+    for (uint32_t i = 0; i < iterations; i++) {
+        fn(i);
+    }
+    Ticks elapsed = nowTicks() - start;
+    uint32_t allocated = allocations - allocationsBefore;
+
+    char line[224];
+#ifdef ARDUINO
+    snprintf(line, sizeof(line),
+             "{\"bench\":\"%s\",\"target\":\"%s\",\"iterations\":%lu,\"ns_per_op\":%.2f,"
+             "\"cycles_per_op\":%.2f,\"allocs_per_op\":%.3f}",
+             name, TARGET, (unsigned long)iterations, ticksToNs(elapsed) / iterations,
+             static_cast<double>(elapsed) / iterations, static_cast<double>(allocated) / iterations);
+#else
+    snprintf(line, sizeof(line),
+             "{\"bench\":\"%s\",\"target\":\"%s\",\"iterations\":%lu,\"ns_per_op\":%.2f,"
+             "\"allocs_per_op\":%.3f}",
+             name, TARGET, (unsigned long)iterations, ticksToNs(elapsed) / iterations,
+             static_cast<double>(allocated) / iterations);
+#endif
+    emit(line);
+}
+
+}  // namespace bench
+
+#endif
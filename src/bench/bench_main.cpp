@@ -0,0 +1,302 @@
+// Microbenchmarks for the color and command hot paths. Not part of the
+// firmware; built by the bench_native and bench_esp32 environments:
+//   pio run -e bench_native && .pio/build/bench_native/program > bench.jsonl
+//   pio run -e bench_esp32 -t upload && pio device monitor -e bench_esp32
+// Compare two runs with scripts/bench_compare.py.
+
+#include <stdlib.h>
+#include <string.h>
+#include "Bench.h"
+#include "LEDController.h"
+#include "LTTController.h"
+#include "ColorPipeline.h"
+#include "PwmTables.h"
+#include "PowerGovernor.h"
+#include "LedOutput.h"
+#include "TemporalDither.h"
+#include "Filters.h"
+#include "FadeEngine.h"
+#include "EffectsEngine.h"
+#include "LightCommandParser.h"
+#include "StatePublisher.h"
+
+volatile uint32_t bench::allocations = 0;
+
+// Count every heap allocation made while a case runs (see the -Wl,--wrap
+// flags in platformio.ini). operator new is routed through malloc so it is
+// counted once too.
+extern "C"
+{
+  void *__real_malloc(size_t size);
+  void *__real_calloc(size_t count, size_t size);
+  void *__real_realloc(void *ptr, size_t size);
+
+  void *__wrap_malloc(size_t size)
+  {
+    bench::allocations = bench::allocations + 1;
+    return __real_malloc(size);
+  }
+
+  void *__wrap_calloc(size_t count, size_t size)
+  {
+    bench::allocations = bench::allocations + 1;
+    return __real_calloc(count, size);
+  }
+
+  void *__wrap_realloc(void *ptr, size_t size)
+  {
+    bench::allocations = bench::allocations + 1;
+    return __real_realloc(ptr, size);
+  }
+}
+
+void *operator new(size_t size)
+{
+  void *ptr = malloc(size);
+  if (!ptr)
+  {
+    abort();
+  }
+  return ptr;
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete(void *ptr) noexcept { free(ptr); }
+void operator delete[](void *ptr) noexcept { free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { free(ptr); }
+
+// Same pins as main.cpp; on the device the LEDs will flicker during the run
+SettingsStore settings("led", 2000, 30000);
+const PowerChannel LED_POWER_MODEL[COLOR_CHANNELS] = {{350, 2.2f}, {350, 3.2f}, {350, 3.2f}};
+PowerGovernor powerGovernor(LED_POWER_MODEL, 60000, 0.8f);
+constexpr LedPin LAMP_PINS[] = {{7, 0}, {6, 1}, {5, 2}};
+LedOutput<LAMP_PINS> ledOutput;
+TemporalDither temporalDither(ledOutput);
+LEDController ledController(settings, powerGovernor, ledOutput, temporalDither);
+
+const uint32_t INPUT_COUNT = 256; // Power of two, indexed with i & (INPUT_COUNT - 1)
+int inputs[INPUT_COUNT];
+
+// A full Home Assistant JSON command, as sent by a color picker drag
+const char COMMAND_PAYLOAD[] =
+    "{\"state\":\"ON\",\"color\":{\"r\":255,\"g\":180,\"b\":100},\"brightness\":200,"
+    "\"transition\":0.5,\"color_mode\":\"rgb\",\"effect\":\"none\"}";
+
+void fillInputs()
+{
+  uint32_t seed = 0x12345678;
+  for (uint32_t i = 0; i < INPUT_COUNT; i++)
+  {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    inputs[i] = static_cast<int>(seed % PWM_LEVELS);
+  }
+}
+
+inline int input(uint32_t i) { return inputs[i & (INPUT_COUNT - 1)]; }
+
+void benchFilters()
+{
+  static MovingAverage<8> movingAverage;
+  static ExponentialAverage<3> exponentialAverage;
+  static MedianFilter<5> median;
+  static OneEuroFilter<200, 1000, 5000> oneEuro;
+
+  bench::run("filter_moving_average_8", 100000, [](uint32_t i)
+             { bench::doNotOptimize(movingAverage.update(input(i))); });
+  bench::run("filter_exponential_average", 100000, [](uint32_t i)
+             { bench::doNotOptimize(exponentialAverage.update(input(i))); });
+  bench::run("filter_median_5", 100000, [](uint32_t i)
+             { bench::doNotOptimize(median.update(input(i))); });
+  bench::run("filter_one_euro", 100000, [](uint32_t i)
+             { bench::doNotOptimize(oneEuro.update(input(i))); });
+}
+
+void benchColor()
+{
+  // The float mix the CCT engine replaced. On a host FPU it is about three
+  // times as fast as ltt_to_fine (6 ns against 20 ns); whether the integer
+  // path wins against soft-float on the C3 needs a bench_esp32 run, which
+  // has not been done yet (see Measurements in the README)
+  bench::run("ltt_to_rgb", 100000, [](uint32_t i)
+             {
+               int r, g, b;
+               LTTController::lttToRgb(input(i), input(i + 1), input(i + 2), r, g, b);
+               bench::doNotOptimize(r + g + b);
+             });
+  // The CCT engine that replaced it, from the same knob positions: knob
+  // mapping, Planckian table interpolation, tint and trim
+  bench::run("ltt_to_fine", 100000, [](uint32_t i)
+             {
+               LinearColor duty = LampPipeline::run(LTTController::lttToColor(input(i), input(i + 1), input(i + 2)));
+               bench::doNotOptimize(duty.c[0] + duty.c[1] + duty.c[2]);
+             });
+  // The table lookup against the same Planckian color computed in float
+  bench::run("cct_render", 100000, [](uint32_t i)
+             {
+               int fine[COLOR_CHANNELS];
+               cct::render(CCT_MIN_K + input(i) * 2, (input(i + 1) >> 2) - DUV_LIMIT, input(i + 2) << DITHER_BITS, fine);
+               bench::doNotOptimize(fine[0] + fine[1] + fine[2]);
+             });
+  bench::run("cct_render_float", 10000, [](uint32_t i)
+             {
+               int fine[COLOR_CHANNELS];
+               cct::renderFloat(CCT_MIN_K + input(i) * 2, (input(i + 1) >> 2) - DUV_LIMIT, input(i + 2) << DITHER_BITS, fine);
+               bench::doNotOptimize(fine[0] + fine[1] + fine[2]);
+             });
+  // The whole color pipeline from each kind of source: gamma, brightness,
+  // correction, trim and clamp in one inlined pass
+  bench::run("pipeline_color8", 100000, [](uint32_t i)
+             {
+               const uint8_t rgb[COLOR_CHANNELS] = {static_cast<uint8_t>(input(i)), static_cast<uint8_t>(input(i + 1)),
+                                                    static_cast<uint8_t>(input(i + 2))};
+               LinearColor duty = LampPipeline::run(color_source::fromColor8(rgb, static_cast<uint8_t>(i)));
+               bench::doNotOptimize(duty.c[0] + duty.c[1] + duty.c[2]);
+             });
+  bench::run("pipeline_duty", 100000, [](uint32_t i)
+             {
+               LinearColor duty = LampPipeline::run(color_source::fromDuty(input(i), input(i + 1), input(i + 2)));
+               bench::doNotOptimize(duty.c[0] + duty.c[1] + duty.c[2]);
+             });
+
+  bench::run("power_governor_scale", 100000, [](uint32_t i)
+             { bench::doNotOptimize(powerGovernor.scale(input(i))); });
+  // One control tick of the thermal model; 20 ms steps as in the firmware
+  bench::run("power_governor_update", 20000, [](uint32_t i)
+             {
+               int duty[COLOR_CHANNELS] = {input(i), input(i + 1), input(i + 2)};
+               bench::doNotOptimize(powerGovernor.update(duty, i * 20));
+             });
+  powerGovernor.reset();
+
+  // One 4 kHz tick with every channel between two duties (the worst case)
+  static TemporalDither benchDither(ledOutput);
+  benchDither.start();
+  for (int c = 0; c < COLOR_CHANNELS; c++)
+  {
+    benchDither.set(c, static_cast<uint16_t>((input(c) << DITHER_BITS) | (5 + c)));
+  }
+  benchDither.commit();
+  bench::run("temporal_dither_tick", 100000, [](uint32_t i)
+             { benchDither.tick(); });
+  bench::run("apply_power_limit_float", 100000, [](uint32_t i)
+             {
+               int r = input(i), g = input(i + 1), b = input(i + 2);
+               ledController.applyPowerLimit(r, g, b);
+               bench::doNotOptimize(r + g + b);
+             });
+  // The per-write math of the original writePWM path, float trim and then
+  // the power limit per channel, against what replaced it: the pipeline's
+  // Q15 trim and the governor's shared scale
+  bench::run("write_path_float", 100000, [](uint32_t i)
+             {
+               const float limit = 0.6f;
+               int r = static_cast<int>(static_cast<int>(input(i) * RED_TRIM) * limit);
+               int g = static_cast<int>(static_cast<int>(input(i + 1) * GREEN_TRIM) * limit);
+               int b = static_cast<int>(static_cast<int>(input(i + 2) * BLUE_TRIM) * limit);
+               bench::doNotOptimize(r + g + b);
+             });
+  bench::run("write_path_fixed", 100000, [](uint32_t i)
+             {
+               LinearColor duty = LampPipeline::run(color_source::fromDuty(input(i), input(i + 1), input(i + 2)));
+               bench::doNotOptimize(powerGovernor.scale(duty.c[0]) + powerGovernor.scale(duty.c[1]) +
+                                    powerGovernor.scale(duty.c[2]));
+             });
+}
+
+void benchLedController()
+{
+  bench::run("should_update", 100000, [](uint32_t i)
+             { bench::doNotOptimize(ledController.shouldUpdate(input(i), input(i + 1))); });
+  bench::run("set_pwm_directly", 20000, [](uint32_t i)
+             { ledController.setPWMDirectly(input(i), input(i + 1), input(i + 2)); });
+  bench::run("set_color8", 20000, [](uint32_t i)
+             { ledController.setColor8(input(i) & 0xFF, input(i + 1) & 0xFF, input(i + 2) & 0xFF); });
+
+  static FadeEngine fadeEngine(ledController);
+  fadeEngine.fadeTo(color_source::fromDuty(PWM_MAX, PWM_MAX / 2, 0), 0xFFFFFFF, 0);
+  bench::run("fade_update", 20000, [](uint32_t i)
+             { fadeEngine.update(i); });
+}
+
+void benchEffects()
+{
+  static EffectsEngine effectsEngine(ledController);
+  effectsEngine.setBaseColor(255, 180, 100, 255);
+  const Effect effects[] = {Effect::BREATHE, Effect::COLOR_CYCLE, Effect::CANDLE, Effect::RAINBOW};
+  for (Effect effect : effects)
+  {
+    char name[40];
+    snprintf(name, sizeof(name), "effect_render_%s", EffectsEngine::effectName(effect));
+    effectsEngine.setEffect(effect, 0);
+    bench::run(name, 20000, [](uint32_t i)
+               {
+                 LinearColor color;
+                 effectsEngine.render(i * 10, color);
+                 bench::doNotOptimize(color);
+               });
+  }
+  effectsEngine.stop();
+}
+
+void benchCommands()
+{
+  static LightCommandParser parser;
+  static char payload[sizeof(COMMAND_PAYLOAD)];
+  // Includes copying the payload in, as PubSubClient hands over a fresh buffer
+  bench::run("parse_light_command", 5000, [](uint32_t i)
+             {
+               memcpy(payload, COMMAND_PAYLOAD, sizeof(COMMAND_PAYLOAD) - 1);
+               LightCommand command;
+               parser.parse(payload, sizeof(COMMAND_PAYLOAD) - 1, command);
+               bench::doNotOptimize(command);
+             });
+
+  static StatePublisher publisher(250);
+  bench::run("state_publisher_submit_poll", 50000, [](uint32_t i)
+             {
+               LightState state;
+               state.on = true;
+               state.color.rgb[0] = static_cast<uint8_t>(input(i));
+               publisher.submit(state, i);
+               uint8_t fields = 0;
+               bench::doNotOptimize(publisher.poll(i, fields));
+             });
+}
+
+void runSuite()
+{
+  fillInputs();
+  ledController.begin();
+  ledController.setRGBModePowerLimit();
+
+  benchFilters();
+  benchColor();
+  benchLedController();
+  benchEffects();
+  benchCommands();
+  ledController.setPWMForced(0, 0, 0);
+}
+
+#ifdef ARDUINO
+void setup()
+{
+  Serial.begin(115200);
+  delay(2000); // Give the USB CDC console time to attach
+  runSuite();
+  Serial.println("{\"done\":true}");
+}
+
+void loop()
+{
+  delay(1000);
+}
+#else
+int main()
+{
+  runSuite();
+  return 0;
+}
+#endif
@@ -1,13 +1,36 @@
+#ifdef ARDUINO
+// Firmware entry point; host builds use sim_main.cpp instead
+
 #include <Arduino.h>
 #include "LEDController.h"
 #include "LTTController.h"
 #include "WiFiManager.h"
 #include "MQTTController.h"
 #include "state.h"
+#include "Scheduler.h"
+#include "PotSampler.h"
+#include "Filters.h"
+#include "FadeEngine.h"
+#include "EffectsEngine.h"
+#include "BlinkPattern.h"
+#include "Log.h"
+#include "Hal.h"
+#include "Telemetry.h"
+#include "SettingsStore.h"
+#include "PowerGovernor.h"
+#include "LedOutput.h"
+#include "TemporalDither.h"
+#include "LampSnapshot.h"
+#include "LatencyTrace.h"
+#include <inttypes.h>
 
-const int RED_PIN = 5;
-const int GREEN_PIN = 6;
-const int BLUE_PIN = 7;
+// Color order -> GPIO and LEDC channel. The red LED is on GPIO 7 and the
+// blue one on GPIO 5; this map replaces the swap begin() used to do.
+constexpr LedPin LAMP_PINS[] = {
+    {7, 0},  // Red
+    {6, 1},  // Green
+    {5, 2},  // Blue
+};
 
 const int POT_RED_PIN = 4;
 const int POT_GREEN_PIN = 3;
@@ -15,10 +38,9 @@ const int POT_BLUE_PIN = 0;
 
 const int MOVING_AVERAGE_SIZE = 8; // Size of the moving average window
 
-int pot1Values[MOVING_AVERAGE_SIZE] = {0};
-int pot2Values[MOVING_AVERAGE_SIZE] = {0};
-int pot3Values[MOVING_AVERAGE_SIZE] = {0};
-int potIndex = 0;
+// Swap MovingAverage for ExponentialAverage, MedianFilter or OneEuroFilter
+// (see Filters.h) to change how the knobs are smoothed
+FilterBank<MovingAverage<MOVING_AVERAGE_SIZE>, POT_COUNT> potFilters;
 
 int lastPot1 = 0;
 int lastPot2 = 0;
@@ -28,184 +50,378 @@ int lastPot3 = 0;
 //const int potInterval = 50; // Check every 50ms
 //bool potChanged = false;
 
-LEDController ledController(
-    RED_PIN, GREEN_PIN, BLUE_PIN,
-    0, 1, 2);
+SettingsStore settings(SETTINGS_NAMESPACE, SETTINGS_SETTLE_MS, SETTINGS_MAX_DELAY_MS);
+SnapshotKeeper snapshotKeeper(settings);
+
+const PowerChannel LED_POWER_MODEL[COLOR_CHANNELS] = {
+    {POWER_RED_MA, POWER_RED_VF},
+    {POWER_GREEN_MA, POWER_GREEN_VF},
+    {POWER_BLUE_MA, POWER_BLUE_VF},
+};
+PowerGovernor powerGovernor(LED_POWER_MODEL, POWER_THERMAL_TAU_MS, POWER_DERATE_KNEE);
+LedOutput<LAMP_PINS> ledOutput;
+TemporalDither temporalDither(ledOutput);
+
+LEDController ledController(settings, powerGovernor, ledOutput, temporalDither);
 
 LTTController lttController(ledController);
 WiFiManager wifiManager(ledController);
-MQTTController mqttController(ledController);
+FadeEngine fadeEngine(ledController);
+EffectsEngine effectsEngine(ledController);
+TelemetryCollector telemetryCollector(TELEMETRY_PUBLISH_PERIOD_MS);
+MQTTController mqttController(ledController, fadeEngine, effectsEngine, telemetryCollector);
 StateHandler stateHandler(ledController);
+BlinkPattern blinkPattern(ledController);
+PotSampler potSampler;
+
+EspTimerClock schedulerClock;
+Scheduler scheduler(schedulerClock);
 
-int readAveragedADC(int pin, int samples = 4)
+// Rate group periods (us)
+const uint32_t ADC_PERIOD_US = 5000;          // 200 Hz
+const uint32_t BUTTON_PERIOD_US = 10000;      // 100 Hz
+const uint32_t FADE_PERIOD_US = 10000;        // 100 Hz
+const uint32_t EFFECTS_PERIOD_US = EffectsEngine::FRAME_MS * 1000;
+const uint32_t COMMAND_PERIOD_US = 20000;     // 50 Hz
+const uint32_t CONTROL_PERIOD_US = 20000;     // 50 Hz
+const uint32_t SETTINGS_PERIOD_US = 100000;   // 10 Hz
+const uint32_t TELEMETRY_PERIOD_US = 1000000; // 1 Hz
+
+// Task priorities: effects frames > control loop > WiFi/MQTT
+const UBaseType_t EFFECTS_TASK_PRIORITY = 3;
+const UBaseType_t CONTROL_TASK_PRIORITY = 2;
+const UBaseType_t NETWORK_TASK_PRIORITY = 1;
+const UBaseType_t LOG_TASK_PRIORITY = 0;      // Only drains when everything else is idle
+
+void blinkRedLight() {
+  // Blink red light three times; stepped by runControl() so loop() never blocks
+  blinkPattern.start(2047, 0, 0, 3, 300, millis());
+}
+
+void sampleAdc()
 {
-  int32_t sum = 0;
-  for (int i = 0; i < samples; i++)
+  // Frames arrive already averaged from the DMA sampler task; just drain them
+  PotFrame frame;
+  while (potSampler.pop(frame))
   {
-    sum += analogReadMilliVolts(pin);
+    int pot1 = frame.millivolts[0];
+    int pot2 = frame.millivolts[1];
+    int pot3 = frame.millivolts[2];
+
+    pot1 = map(constrain(pot1, 5, 950), 5, 950, 0, 2047); // Left pot (meant for Red)
+    pot2 = map(constrain(pot2, 5, 950), 5, 950, 0, 2047); // Middle pot (meant for Green)
+    pot3 = map(constrain(pot3, 5, 950), 5, 950, 0, 2047); // Right pot (meant for Blue)
+
+    potFilters.update(0, pot1);
+    potFilters.update(1, pot2);
+    potFilters.update(2, pot3);
   }
-  return sum / samples;
 }
 
-int calculateMovingAverage(int *values, int size)
+void pollButton()
+{
+  stateHandler.update();
+}
+
+void updateFade()
+{
+  fadeEngine.update(millis());
+}
+
+void applyEffectFrame()
+{
+  // Rendered on the effects task; written here so the LEDs have one writer
+  effectsEngine.applyFrame();
+}
+
+void applyMqttCommands()
 {
-  int sum = 0;
-  for (int i = 0; i < size; i++)
+  // WiFi mode disabled; WebSocket frames and web_total latencies stay
+  // inert until this drain is back
+  // if (stateHandler.getCurrentMode() == OperationMode::WIFI)
+  // {
+  //   wifiManager.update();
+  // }
+  // Networking itself runs on its own task; only parsed commands land here
+  if (stateHandler.getCurrentMode() == OperationMode::MQTT)
   {
-    sum += values[i];
+    mqttController.applyPendingCommands();
   }
-  return sum / size;
 }
 
-void blinkRedLight() {
-  // Blink red light three times
-  for (int i = 0; i < 3; i++) {
-    ledController.setPWMDirectly(2047, 0, 0); // Red on
-    delay(300);
-    ledController.setPWMDirectly(0, 0, 0); // Off
-    delay(300);
+void runControl()
+{
+  // Thermal budget follows whatever was written since the last tick
+  ledController.updatePower(millis());
+
+  // Filtered pot values
+  int pot1 = potFilters.value(0);
+  int pot2 = potFilters.value(1);
+  int pot3 = potFilters.value(2);
+
+  //Serial.print("pot1: ");
+  //Serial.print(pot1);
+  //Serial.print(", pot2: ");
+  //Serial.print(pot2);
+  //Serial.print(", pot3: ");
+  //Serial.println(pot3);
+
+  // static bool wasInWiFiMode = false; // WiFi mode disabled
+  static bool wasInMQTTMode = false;
+  static bool wasInRGBMode = false;
+  static bool wasInLTTMode = false;
+  static bool mqttFailureHandled = false;
+  // bool isInWiFiMode = stateHandler.getCurrentMode() == OperationMode::WIFI; // WiFi mode disabled
+  bool isInMQTTMode = stateHandler.getCurrentMode() == OperationMode::MQTT;
+  bool isInRGBMode = stateHandler.getCurrentMode() == OperationMode::RGB;
+  bool isInLTTMode = stateHandler.getCurrentMode() == OperationMode::LTT;
+
+  // WiFi mode disabled
+  // if (isInWiFiMode && !wasInWiFiMode)
+  // {
+  //   wifiManager.begin();
+  //   ledController.checkAndUpdatePowerLimit();
+  // }
+  // else if (!isInWiFiMode && wasInWiFiMode)
+  // {
+  //   wifiManager.stop();
+  //   ledController.setPWMDirectly(0, 0, 0);
+  //   ledController.checkAndUpdatePowerLimit();
+  // }
+
+  if (isInMQTTMode && !wasInMQTTMode)
+  {
+    ledController.setMQTTModePowerLimit();
+    mqttController.start();
+    mqttFailureHandled = false;
+  }
+  else if (!isInMQTTMode && wasInMQTTMode)
+  {
+    mqttController.stop();
+    effectsEngine.stop();
+    fadeEngine.cancel();
+    ledController.setPWMDirectly(0, 0, 0);
+  }
+
+  if (isInRGBMode && !wasInRGBMode)
+  {
+    ledController.setRGBModePowerLimit();
+  }
+
+  // LTT is a knob mode too and shares the RGB limit
+  if (isInLTTMode && !wasInLTTMode)
+  {
+    ledController.setRGBModePowerLimit();
+    lttController.invalidate();
+  }
+
+  // Check for MQTT connection failure and fallback to RGB mode
+  if (isInMQTTMode && !mqttFailureHandled && mqttController.hasInitialConnectionFailed())
+  {
+    LOG_W("MQTT connection failed! Blinking red light and falling back to RGB mode...");
+    blinkRedLight();
+    stateHandler.setMode(OperationMode::RGB);
+    mqttController.stop();
+    effectsEngine.stop();
+    fadeEngine.cancel();
+    mqttFailureHandled = true;
+    isInMQTTMode = false;
+  }
+
+  // wasInWiFiMode = isInWiFiMode; // WiFi mode disabled
+  wasInMQTTMode = isInMQTTMode;
+  wasInRGBMode = isInRGBMode;
+  wasInLTTMode = isInLTTMode;
+
+  // A failure blink owns the LEDs until it finishes
+  if (blinkPattern.update(millis()))
+  {
+    return;
+  }
+
+  switch (stateHandler.getCurrentMode())
+  {
+  case OperationMode::RGB:
+    // pot1 is the LEFT knob and pot3 the RIGHT one; the right knob drives
+    // red (GPIO 7) and the left one blue (GPIO 5), as on the original build
+    ledController.setPWMDirectly(pot3, pot2, pot1);
+    break;
+  case OperationMode::MQTT:
+    // LED control happens via MQTT
+    break;
+  case OperationMode::LTT:
+    // Left knob luminance, middle color temperature (warm to the left),
+    // right tint (centre detent on the Planckian locus)
+    lttController.updateLTT(pot1, pot2, pot3);
+    break;
+
+  // Temporarily disabled modes:
+  // case OperationMode::POWERCON:
+  //   {
+  //     float powerLimit = map(pot2, 0, 2047, 50, 1000) / 1000.0f;
+  //     ledController.setPowerLimit(powerLimit);
+  //     ledController.setPWMForced(2047, 2047, 2047);
+  //   }
+  //   break;
+  // case OperationMode::OFF:
+  // case OperationMode::WIFI:
+  //   break;
   }
 }
 
-void setup()
+void persistState()
 {
-  Serial.begin(115200);
-  Serial.println("Color Shadow Lamp starting up...");
-  ledController.begin();
-  stateHandler.begin();
-
-  analogSetAttenuation(ADC_2_5db);
-  analogSetPinAttenuation(POT_RED_PIN, ADC_2_5db);
-  analogSetPinAttenuation(POT_GREEN_PIN, ADC_2_5db);
-  analogSetPinAttenuation(POT_BLUE_PIN, ADC_2_5db);
+  // RTC copy is refreshed on every change; flash goes through the debounce.
+  // The button-selected mode is kept, so an MQTT fallback to RGB doesn't
+  // stop the next boot from trying the broker again.
+  LampSnapshot snapshot;
+  snapshot.mode = static_cast<uint8_t>(stateHandler.getSelectedMode());
+  snapshot.light = mqttController.getLightState();
+  snapshotKeeper.save(snapshot);
+  settings.update(millis());
 }
 
-void loop()
+// Before any networking: bring back the last mode and light so the lamp
+// is lit within a few hundred ms of power-up
+void restoreSnapshot()
 {
-  static unsigned long lastUpdate = 0;
-  const unsigned long UPDATE_INTERVAL = 20;
+  LampSnapshot snapshot;
+  SnapshotSource source = snapshotKeeper.restore(snapshot);
+  OperationMode mode = OperationMode::MQTT;
+  if (source != SnapshotSource::NONE && (snapshot.mode == static_cast<uint8_t>(OperationMode::RGB) ||
+                                          snapshot.mode == static_cast<uint8_t>(OperationMode::LTT)))
+  {
+    mode = static_cast<OperationMode>(snapshot.mode);
+  }
+  stateHandler.begin(mode);
 
-  unsigned long currentMillis = millis();
-  if (currentMillis - lastUpdate >= UPDATE_INTERVAL)
+  // Knob modes follow the knobs as soon as the control loop runs
+  if (source == SnapshotSource::NONE || mode != OperationMode::MQTT)
   {
-    lastUpdate = currentMillis;
-    stateHandler.update();
+    LOG_I("No light state restored (%s, mode %s)", SnapshotKeeper::sourceName(source),
+          StateHandler::modeName(mode));
+    return;
+  }
+
+  ledController.setMQTTModePowerLimit();
+  mqttController.restoreState(snapshot.light);
+  // esp_timer starts with the app, so this leaves out the ~100 ms bootloader
+  uint32_t bootToLightMs = static_cast<uint32_t>(hal::nowUs() / 1000);
+  if (snapshot.light.on)
+  {
+    telemetryCollector.recordBootToLight(bootToLightMs);
+  }
+  const ColorState& color = snapshot.light.color;
+  LOG_I("Restored %s R=%d G=%d B=%d K=%u brightness=%d effect=%s from %s in %" PRIu32 " ms since boot",
+        snapshot.light.on ? "ON" : "OFF", color.rgb[0], color.rgb[1], color.rgb[2], color.kelvin, color.brightness,
+        EffectsEngine::effectName(snapshot.light.effect), SnapshotKeeper::sourceName(source), bootToLightMs);
+}
 
-    // WiFi mode disabled
-    // if (stateHandler.getCurrentMode() == OperationMode::WIFI)
-    // {
-    //   wifiManager.update();
-    // }
-    if (stateHandler.getCurrentMode() == OperationMode::MQTT)
+void reportTelemetry()
+{
+  telemetryCollector.recordHeap(ESP.getFreeHeap(), ESP.getMinFreeHeap());
+  if (telemetryCollector.due(millis()))
+  {
+    mqttController.reportTelemetry(telemetryCollector.take(millis()));
+  }
+
+#ifdef DEBUG_SCHEDULER
+  for (int i = 0; i < scheduler.getGroupCount(); i++)
+  {
+    const RateGroup &group = scheduler.getGroup(i);
+    char histogram[RateGroup::JITTER_BUCKETS * 11];
+    int length = 0;
+    for (int b = 0; b < RateGroup::JITTER_BUCKETS; b++)
     {
-      mqttController.update();
+      length += snprintf(histogram + length, sizeof(histogram) - length, "%s%" PRIu32, b ? "/" : "",
+                         group.jitterHistogram[b]);
     }
+    LOG_I("[sched] %-9s runs=%" PRIu32 " overruns=%" PRIu32 " last=%" PRIu32 "us max=%" PRIu32
+          "us jitter_max=%" PRIu32 "us latency_max=%" PRIu32 "us hist=%s",
+          group.name, group.runs, group.overruns, group.lastRunUs, group.maxRunUs, group.maxJitterUs,
+          group.maxLatencyUs, histogram);
+  }
+  const EffectStats &fx = effectsEngine.getStats();
+  LOG_I("[fx] frames=%" PRIu32 " last=%" PRIu32 "us max=%" PRIu32 "us avg=%" PRIu32 "us late=%" PRIu32,
+        fx.frames, fx.lastRenderUs, fx.maxRenderUs, fx.frames ? fx.totalRenderUs / fx.frames : 0, fx.lateFrames);
+  LOG_I("[mqtt] dropped_commands=%" PRIu32 " superseded_states=%" PRIu32 " states_sent=%" PRIu32
+        " states_suppressed=%" PRIu32,
+        mqttController.getDroppedCommands(), mqttController.getSupersededStates(),
+        mqttController.getPublishedStates(), mqttController.getSuppressedStates());
+  LOG_I("[pots] dropped=%" PRIu32 " dma_overflows=%" PRIu32, potSampler.getDroppedFrames(),
+        potSampler.getDmaOverflows());
+  LOG_I("[log] written=%" PRIu32 " dropped=%" PRIu32, Log::getWritten(), Log::getDropped());
+  const SettingsStats &nvs = settings.getStats();
+  LOG_I("[nvs] reads=%" PRIu32 " puts=%" PRIu32 " unchanged=%" PRIu32 " flushes=%" PRIu32 " written=%" PRIu32
+        " reverted=%" PRIu32 " failed=%" PRIu32,
+        nvs.reads, nvs.puts, nvs.unchangedPuts, nvs.flushes, nvs.keysWritten, nvs.keysReverted, nvs.failedFlushes);
+  for (int s = 0; s < LatencyTrace::STAGE_COUNT; s++)
+  {
+    LatencyTrace::Stage stage = static_cast<LatencyTrace::Stage>(s);
+    LatencyTrace::Histogram h = LatencyTrace::histogram(stage);
+    LOG_I("[latency] %-11s n=%" PRIu32 " min=%" PRIu32 "us avg=%" PRIu32 "us max=%" PRIu32 "us",
+          LatencyTrace::stageName(stage), h.count, h.minUs, h.avgUs(), h.maxUs);
+  }
+  LOG_I("[latency] expired=%" PRIu32, LatencyTrace::getExpired());
+  const PowerStats &power = powerGovernor.getStats();
+  LOG_I("[power] limit=%.2f heat=%.3f scale=%.3f current=%.0fmA peak=%.0fmA min_scale=%.3f throttled=%" PRIu32 "ms",
+        powerGovernor.getSustainedLimit(), powerGovernor.getHeat(), powerGovernor.getScale(),
+        powerGovernor.getCurrentMa(), power.peakCurrentMa, power.minScale, power.throttledMs);
+  const DitherStats &dither = temporalDither.getStats();
+  // max_tick bounds how late a dither callback can make the scheduler tick
+  LOG_I("[dither] idle=%d ticks=%" PRIu32 " writes=%" PRIu32 " latches=%" PRIu32 " wakeups=%" PRIu32
+        " max_tick=%" PRIu32 "us busy=%" PRIu32 "ms",
+        temporalDither.isIdle(), dither.ticks, dither.writes, dither.latches, dither.wakeups, dither.maxTickUs,
+        static_cast<uint32_t>(dither.busyUs / 1000));
+#endif
+}
 
-    int pot1 = readAveragedADC(POT_RED_PIN);
-    int pot2 = readAveragedADC(POT_GREEN_PIN);
-    int pot3 = readAveragedADC(POT_BLUE_PIN);
+void setup()
+{
+  // loop() runs the control rate groups; keep it above the network task
+  vTaskPrioritySet(nullptr, CONTROL_TASK_PRIORITY);
 
-    pot1 = map(constrain(pot1, 5, 950), 5, 950, 0, 2047); // Left pot (meant for Red)
-    pot2 = map(constrain(pot2, 5, 950), 5, 950, 0, 2047); // Middle pot (meant for Green)
-    pot3 = map(constrain(pot3, 5, 950), 5, 950, 0, 2047); // Right pot (meant for Blue)
+  Serial.begin(115200);
+  if (!Log::begin(LOG_TASK_PRIORITY))
+  {
+    Serial.println("Log task failed to start - logging directly to Serial");
+  }
+  LOG_I("Color Shadow Lamp starting up...");
+  ledController.begin();
+  if (!temporalDither.begin(DITHER_TICK_US))
+  {
+    LOG_E("Temporal dither failed to start - output truncated to 11 bits");
+  }
+  restoreSnapshot();
 
-    // Update moving average arrays
-    pot1Values[potIndex] = pot1;
-    pot2Values[potIndex] = pot2;
-    pot3Values[potIndex] = pot3;
-    potIndex = (potIndex + 1) % MOVING_AVERAGE_SIZE;
-
-    // Calculate moving averages
-    pot1 = calculateMovingAverage(pot1Values, MOVING_AVERAGE_SIZE);
-    pot2 = calculateMovingAverage(pot2Values, MOVING_AVERAGE_SIZE);
-    pot3 = calculateMovingAverage(pot3Values, MOVING_AVERAGE_SIZE);
-
-    //Serial.print("pot1: ");
-    //Serial.print(pot1);
-    //Serial.print(", pot2: ");
-    //Serial.print(pot2);
-    //Serial.print(", pot3: ");
-    //Serial.println(pot3);
-
-    // static bool wasInWiFiMode = false; // WiFi mode disabled
-    static bool wasInMQTTMode = false;
-    static bool wasInRGBMode = false;
-    static bool mqttFailureHandled = false;
-    // bool isInWiFiMode = stateHandler.getCurrentMode() == OperationMode::WIFI; // WiFi mode disabled
-    bool isInMQTTMode = stateHandler.getCurrentMode() == OperationMode::MQTT;
-    bool isInRGBMode = stateHandler.getCurrentMode() == OperationMode::RGB;
-
-    // WiFi mode disabled
-    // if (isInWiFiMode && !wasInWiFiMode)
-    // {
-    //   wifiManager.begin();
-    //   ledController.checkAndUpdatePowerLimit();
-    // }
-    // else if (!isInWiFiMode && wasInWiFiMode)
-    // {
-    //   wifiManager.stop();
-    //   ledController.setPWMDirectly(0, 0, 0);
-    //   ledController.checkAndUpdatePowerLimit();
-    // }
-
-    if (isInMQTTMode && !wasInMQTTMode)
-    {
-      ledController.setMQTTModePowerLimit();
-      mqttController.begin();
-      mqttFailureHandled = false;
-    }
-    else if (!isInMQTTMode && wasInMQTTMode)
-    {
-      mqttController.stop();
-      ledController.setPWMDirectly(0, 0, 0);
-    }
+  if (!potSampler.begin(POT_RED_PIN, POT_GREEN_PIN, POT_BLUE_PIN))
+  {
+    LOG_E("Pot sampler failed to start - knobs disabled");
+  }
 
-    if (isInRGBMode && !wasInRGBMode)
-    {
-      ledController.setRGBModePowerLimit();
-    }
+  // Fastest groups first - they get released first within a tick
+  scheduler.addGroup("adc", ADC_PERIOD_US, sampleAdc);
+  scheduler.addGroup("button", BUTTON_PERIOD_US, pollButton);
+  scheduler.addGroup("fade", FADE_PERIOD_US, updateFade);
+  scheduler.addGroup("effects", EFFECTS_PERIOD_US, applyEffectFrame);
+  scheduler.addGroup("commands", COMMAND_PERIOD_US, applyMqttCommands);
+  scheduler.addGroup("control", CONTROL_PERIOD_US, runControl);
+  scheduler.addGroup("settings", SETTINGS_PERIOD_US, persistState);
+  scheduler.addGroup("telemetry", TELEMETRY_PERIOD_US, reportTelemetry);
+  scheduler.begin();
 
-    // Check for MQTT connection failure and fallback to RGB mode
-    if (isInMQTTMode && !mqttFailureHandled && mqttController.hasInitialConnectionFailed())
-    {
-      Serial.println("MQTT connection failed! Blinking red light and falling back to RGB mode...");
-      blinkRedLight();
-      stateHandler.setMode(OperationMode::RGB);
-      mqttController.stop();
-      mqttFailureHandled = true;
-      isInMQTTMode = false;
-    }
+  // Effects render on their own task, independent of the loop() rate groups
+  effectsEngine.begin(EFFECTS_TASK_PRIORITY);
+  mqttController.beginTask(NETWORK_TASK_PRIORITY);
+}
 
-    // wasInWiFiMode = isInWiFiMode; // WiFi mode disabled
-    wasInMQTTMode = isInMQTTMode;
-    wasInRGBMode = isInRGBMode;
+void loop()
+{
+  // Blocks until the esp_timer base tick fires, then releases due groups
+  scheduler.waitForTick();
+  uint64_t start = hal::nowUs();
+  scheduler.tick();
+  telemetryCollector.recordLoopTime(static_cast<uint32_t>(hal::nowUs() - start));
+}
 
-    switch (stateHandler.getCurrentMode())
-    {
-    case OperationMode::RGB:
-      // pot1 is LEFT (physically red), pot3 is RIGHT (physically blue)
-      // since the LED pins are now swapped in begin(), we need to swap these too
-      ledController.setPWMDirectly(pot3, pot2, pot1); // Swap values to match physical layout
-      break;
-    case OperationMode::MQTT:
-      // LED control happens via MQTT
-      break;
-
-    // Temporarily disabled modes:
-    // case OperationMode::LTT:
-    //   lttController.updateLTT(pot1, pot2, pot3);
-    //   break;
-    // case OperationMode::POWERCON:
-    //   {
-    //     float powerLimit = map(pot2, 0, 2047, 50, 1000) / 1000.0f;
-    //     ledController.setPowerLimit(powerLimit);
-    //     ledController.setPWMForced(2047, 2047, 2047);
-    //   }
-    //   break;
-    // case OperationMode::OFF:
-    // case OperationMode::WIFI:
-    //   break;
-    }
-  }
-  delay(2);
-}
\ No newline at end of file
+#endif
@@ -0,0 +1,341 @@
+#ifndef ARDUINO
+// Host simulation of the control path (pio run -e native && .pio/build/native/program).
+// Same classes as the firmware, running against the fake HAL backends: a
+// Home Assistant command sequence drives the fade engine, then a button
+// press switches to RGB mode and recorded pot frames drive the LEDs, then
+// another switches to LTT mode for the same sweep. The color temperature
+// table and the color pipeline are checked on their own first; a failure
+// sets the exit code. The temporal dither has its own tests under test/.
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "HalFake.h"
+#include "Log.h"
+#include "SettingsStore.h"
+#include "LampSnapshot.h"
+#include "PowerGovernor.h"
+#include "LedOutput.h"
+#include "TemporalDither.h"
+#include "LEDController.h"
+#include "LTTController.h"
+#include "ColorPipeline.h"
+#include "FadeEngine.h"
+#include "EffectsEngine.h"
+#include "Scheduler.h"
+#include "PotSampler.h"
+#include "RecordedPotSource.h"
+#include "Filters.h"
+#include "LightCommandParser.h"
+#include "LightCommandApplier.h"
+#include "state.h"
+
+// Pin and channel map as in main.cpp
+constexpr LedPin LAMP_PINS[] = {{7, 0}, {6, 1}, {5, 2}};
+const int BUTTON_PIN = 9;
+
+class HalClock : public SchedulerClock {
+public:
+  uint64_t nowMicros() override { return hal::nowUs(); }
+};
+
+SettingsStore settings("led", 2000, 30000);
+SnapshotKeeper snapshotKeeper(settings);
+
+// Power model as in config.h
+const PowerChannel LED_POWER_MODEL[COLOR_CHANNELS] = {{350, 2.2f}, {350, 3.2f}, {350, 3.2f}};
+PowerGovernor powerGovernor(LED_POWER_MODEL, 60000, 0.8f);
+LedOutput<LAMP_PINS> ledOutput;
+TemporalDither temporalDither(ledOutput);
+
+LEDController ledController(settings, powerGovernor, ledOutput, temporalDither);
+LTTController lttController(ledController);
+
+FadeEngine fadeEngine(ledController);
+EffectsEngine effectsEngine(ledController);
+LightCommandApplier commandApplier(fadeEngine, effectsEngine);
+LightCommandParser commandParser;
+StateHandler stateHandler(ledController);
+PotSampler potSampler;
+FilterBank<MovingAverage<8>, POT_COUNT> potFilters;
+
+HalClock clock;
+Scheduler scheduler(clock);
+
+// Knob sweep, already averaged as the DMA sampler would deliver it
+PotFrame potFrames[64];
+
+int mapPot(int millivolts)
+{
+  // 5..950 mV onto the 11-bit duty range, as main.cpp does
+  millivolts = millivolts < 5 ? 5 : (millivolts > 950 ? 950 : millivolts);
+  return (millivolts - 5) * PWM_MAX / (950 - 5);
+}
+
+void sampleAdc()
+{
+  PotFrame frame;
+  while (potSampler.pop(frame))
+  {
+    for (int i = 0; i < POT_COUNT; i++)
+    {
+      potFilters.update(i, mapPot(frame.millivolts[i]));
+    }
+  }
+}
+
+void pollButton()
+{
+  stateHandler.update();
+}
+
+void updateFade()
+{
+  fadeEngine.update(hal::nowMs());
+}
+
+void renderEffects()
+{
+  effectsEngine.renderFrame(hal::nowMs());
+  effectsEngine.applyFrame();
+}
+
+void runControl()
+{
+  ledController.updatePower(hal::nowMs());
+  if (stateHandler.getCurrentMode() == OperationMode::RGB)
+  {
+    ledController.setPWMDirectly(potFilters.value(2), potFilters.value(1), potFilters.value(0));
+  }
+  else if (stateHandler.getCurrentMode() == OperationMode::LTT)
+  {
+    lttController.updateLTT(potFilters.value(0), potFilters.value(1), potFilters.value(2));
+  }
+}
+
+void persistState()
+{
+  LampSnapshot snapshot;
+  snapshot.mode = static_cast<uint8_t>(stateHandler.getSelectedMode());
+  snapshot.light = commandApplier.getState();
+  snapshotKeeper.save(snapshot);
+  settings.update(hal::nowMs());
+}
+
+// What a reboot would restore: a fresh store and keeper over the same fake
+// NVS, with RTC memory intact (reset) or wiped (power cut)
+void printRestore(const char* event)
+{
+  SettingsStore rebootSettings("led", 2000, 30000);
+  SnapshotKeeper rebootKeeper(rebootSettings);
+  LampSnapshot snapshot;
+  SnapshotSource source = rebootKeeper.restore(snapshot);
+  const ColorState& color = snapshot.light.color;
+  printf("{\"restore\":\"%s\",\"source\":\"%s\",\"mode\":%u,\"on\":%s,\"rgb\":[%u,%u,%u],\"kelvin\":%u,"
+         "\"brightness\":%u,\"effect\":\"%s\"}\n",
+         event, SnapshotKeeper::sourceName(source), (unsigned)snapshot.mode, snapshot.light.on ? "true" : "false",
+         (unsigned)color.rgb[0], (unsigned)color.rgb[1], (unsigned)color.rgb[2], (unsigned)color.kelvin,
+         (unsigned)color.brightness, EffectsEngine::effectName(snapshot.light.effect));
+}
+
+void printLeds(const char* phase)
+{
+  printf("{\"t_ms\":%u,\"phase\":\"%s\",\"mode\":\"%s\",\"pwm\":[%u,%u,%u]}\n",
+         (unsigned)hal::nowMs(), phase,
+         stateHandler.getCurrentMode() == OperationMode::RGB   ? "rgb"
+         : stateHandler.getCurrentMode() == OperationMode::LTT ? "ltt"
+                                                               : "mqtt",
+         (unsigned)hal::fake::pwmDuty(0), (unsigned)hal::fake::pwmDuty(1), (unsigned)hal::fake::pwmDuty(2));
+}
+
+void runFor(uint32_t ms, const char* phase, uint32_t printEveryMs)
+{
+  uint32_t end = hal::nowMs() + ms;
+  while (hal::nowMs() < end)
+  {
+    hal::fake::advanceUs(scheduler.getBaseTickUs());
+    scheduler.tick();
+    if (printEveryMs && hal::nowMs() % printEveryMs == 0)
+    {
+      printLeds(phase);
+    }
+  }
+}
+
+void printPower(const char* phase)
+{
+  printf("{\"t_ms\":%u,\"phase\":\"%s\",\"power_limit\":%.2f,\"peak_limit\":%.2f,\"heat\":%.3f,\"scale\":%.3f,"
+         "\"current_ma\":%.0f,\"pwm\":[%u,%u,%u]}\n",
+         (unsigned)hal::nowMs(), phase, powerGovernor.getSustainedLimit(), powerGovernor.getPeakLimit(),
+         powerGovernor.getHeat(),
+         powerGovernor.getScale(), powerGovernor.getCurrentMa(),
+         (unsigned)hal::fake::pwmDuty(0), (unsigned)hal::fake::pwmDuty(1), (unsigned)hal::fake::pwmDuty(2));
+}
+
+void runPowerPhase(uint32_t ms, const char* phase, uint32_t printEveryMs)
+{
+  for (uint32_t elapsed = 0; elapsed < ms; elapsed += printEveryMs)
+  {
+    runFor(printEveryMs, phase, 0);
+    printPower(phase);
+  }
+}
+
+void sendCommand(const char* json)
+{
+  char payload[128];
+  size_t length = strlen(json);
+  memcpy(payload, json, length);
+
+  LightCommand command;
+  if (commandParser.parse(payload, length, command))
+  {
+    LOG_W("sim: bad command %s", json);
+    return;
+  }
+  commandApplier.apply(command, hal::nowMs());
+}
+
+// The fixed-point table against the same color computed in floating point,
+// across the whole temperature and tint range at full output
+bool checkColorTemperature()
+{
+  double worst = 0.0;
+  uint32_t worstKelvin = 0;
+  int worstDuv = 0;
+  for (uint32_t kelvin = CCT_MIN_K; kelvin <= CCT_MAX_K; kelvin += 7)
+  {
+    for (int duv = -DUV_LIMIT; duv <= DUV_LIMIT; duv += 8)
+    {
+      int fixed[COLOR_CHANNELS];
+      int reference[COLOR_CHANNELS];
+      cct::render(kelvin, duv, PWM_FINE_MAX, fixed);
+      cct::renderFloat(kelvin, duv, PWM_FINE_MAX, reference);
+      for (int c = 0; c < COLOR_CHANNELS; c++)
+      {
+        double error = fabs(fixed[c] - reference[c]) / PWM_FINE_MAX;
+        if (error > worst)
+        {
+          worst = error;
+          worstKelvin = kelvin;
+          worstDuv = duv;
+        }
+      }
+    }
+  }
+  bool ok = worst < 0.01;
+  printf("{\"cct_worst_error\":%.4f,\"kelvin\":%u,\"duv\":%d,\"ok\":%s}\n", worst, (unsigned)worstKelvin, worstDuv,
+         ok ? "true" : "false");
+  return ok;
+}
+
+// 8-bit color and brightness through LampPipeline against the float gamma
+// and trim math it replaces, in fine LSBs (1/16 of an 11-bit step)
+bool checkColorPipeline()
+{
+  double worst = 0.0;
+  for (int level = 0; level < 256; level += 3)
+  {
+    for (int brightness = 1; brightness < 256; brightness += 2)
+    {
+      const uint8_t rgb[COLOR_CHANNELS] = {static_cast<uint8_t>(level), static_cast<uint8_t>(255 - level), 128};
+      LinearColor duty = LampPipeline::run(color_source::fromColor8(rgb, static_cast<uint8_t>(brightness)));
+      for (int c = 0; c < COLOR_CHANNELS; c++)
+      {
+        double reference = pow(rgb[c] / 255.0, LED_GAMMA) * pow(brightness / 255.0, LED_GAMMA) * PWM_FINE_MAX *
+                           pwm_detail::channelTrim(c);
+        worst = fmax(worst, fabs(duty.c[c] - reference));
+      }
+    }
+  }
+  bool ok = worst < 3.0;
+  printf("{\"pipeline_worst_lsb\":%.2f,\"ok\":%s}\n", worst, ok ? "true" : "false");
+  return ok;
+}
+
+int main()
+{
+  bool cctOk = checkColorTemperature();
+  bool pipelineOk = checkColorPipeline();
+
+  ledController.begin();
+  ledController.setMQTTModePowerLimit();
+  stateHandler.begin();
+
+  for (int i = 0; i < 64; i++)
+  {
+    uint16_t ramp = static_cast<uint16_t>(5 + i * 15);
+    potFrames[i] = PotFrame{{ramp, 500, static_cast<uint16_t>(950 - i * 15)}, 20};
+  }
+  RecordedPotSource potSource(potSampler, potFrames, 64);
+
+  scheduler.addGroup("adc", 5000, sampleAdc);
+  scheduler.addGroup("button", 10000, pollButton);
+  scheduler.addGroup("fade", 10000, updateFade);
+  scheduler.addGroup("effects", EffectsEngine::FRAME_MS * 1000, renderEffects);
+  scheduler.addGroup("control", 20000, runControl);
+  scheduler.addGroup("settings", 100000, persistState);
+  scheduler.start();
+
+  // Home Assistant: on in warm white over 1 s, then dim, then candle
+  sendCommand("{\"state\":\"ON\",\"color\":{\"r\":255,\"g\":180,\"b\":100},\"transition\":1}");
+  runFor(1200, "fade_on", 100);
+  sendCommand("{\"brightness\":64,\"transition\":0.5}");
+  runFor(600, "dim", 100);
+  sendCommand("{\"color_temp\":370,\"transition\":0.5}");   // 2700 K at the same brightness
+  runFor(600, "color_temp", 100);
+  sendCommand("{\"effect\":\"candle\"}");
+  runFor(300, "candle", 50);
+  printRestore("reset");
+  runFor(2500, "candle", 500);   // Past the settings debounce
+  hal::fake::rtcClear();
+  printRestore("power_cut");
+
+  // Full white, held for two minutes in the shipping (locked) state: a
+  // burst at the locked peak cap until the thermal budget runs out, then a
+  // smooth ramp down onto the MQTT mode's sustained limit. Unlocked, the
+  // same burst runs at full power
+  sendCommand("{\"state\":\"ON\",\"color\":{\"r\":255,\"g\":255,\"b\":255},\"brightness\":255,\"effect\":\"none\"}");
+  runPowerPhase(120000, "locked_burst", 10000);
+  sendCommand("{\"state\":\"OFF\"}");
+  runFor(60000, "cool_down", 0);
+  sendCommand("{\"state\":\"ON\",\"color\":{\"r\":255,\"g\":255,\"b\":255},\"brightness\":255,\"effect\":\"none\"}");
+  ledController.unlock();
+  ledController.setMQTTModePowerLimit();
+  runPowerPhase(20000, "unlocked_burst", 5000);
+  sendCommand("{\"state\":\"OFF\"}");
+  effectsEngine.stop();
+  runFor(100, "off", 100);
+  ledController.resetToSafeMode();
+
+  // Mode button press, then a knob sweep
+  hal::fake::setGpio(BUTTON_PIN, 0);
+  runFor(20, "button", 20);
+  hal::fake::setGpio(BUTTON_PIN, 1);
+  ledController.setRGBModePowerLimit();
+  while (!potSource.finished())
+  {
+    potSource.feed(1);
+    runFor(5, "knobs", 80);
+  }
+
+  // Next press: LTT, the same sweep as luminance, temperature and tint
+  hal::fake::setGpio(BUTTON_PIN, 0);
+  runFor(20, "button", 20);
+  hal::fake::setGpio(BUTTON_PIN, 1);
+  RecordedPotSource lttSource(potSampler, potFrames, 64);
+  while (!lttSource.finished())
+  {
+    lttSource.feed(1);
+    runFor(5, "ltt", 80);
+  }
+
+  printf("{\"pwm_writes\":[%u,%u,%u],\"pwm_latches\":%u,\"nvs_writes\":%u,\"nvs_commits\":%u,"
+         "\"log_dropped\":%u}\n",
+         (unsigned)hal::fake::pwmWrites(0), (unsigned)hal::fake::pwmWrites(1), (unsigned)hal::fake::pwmWrites(2),
+         (unsigned)hal::fake::pwmLatches(),
+         (unsigned)hal::fake::nvsWrites(), (unsigned)hal::fake::nvsCommits(), (unsigned)Log::getDropped());
+  return cctOk && pipelineOk ? 0 : 1;
+}
+
+#endif
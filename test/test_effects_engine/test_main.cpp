@@ -0,0 +1,84 @@
+// Host tests for the effects mailbox (pio test -e native): frames reach the
+// LEDs only through applyFrame(), and never after a stop or a new selection
+
+#include <unity.h>
+#include "HalFake.h"
+#include "SettingsStore.h"
+#include "PowerGovernor.h"
+#include "LedOutput.h"
+#include "TemporalDither.h"
+#include "LEDController.h"
+#include "EffectsEngine.h"
+
+constexpr LedPin LAMP_PINS[] = {{7, 0}, {6, 1}, {5, 2}};
+static const PowerChannel MODEL[COLOR_CHANNELS] = {{350, 2.2f}, {350, 3.2f}, {350, 3.2f}};
+
+struct Lamp
+{
+  SettingsStore settings{"led", 2000, 30000};
+  PowerGovernor governor{MODEL, 60000, 0.8f};
+  LedOutput<LAMP_PINS> output;
+  TemporalDither dither{output};
+  LEDController controller{settings, governor, output, dither};
+  EffectsEngine effects{controller};
+
+  Lamp() { controller.begin(); }
+
+  int fineSum()
+  {
+    int r, g, b;
+    controller.getFineValues(r, g, b);
+    return r + g + b;
+  }
+};
+
+void setUp()
+{
+  hal::fake::reset();
+}
+
+void tearDown() {}
+
+void test_render_alone_does_not_write()
+{
+  Lamp lamp;
+  lamp.effects.setEffect(Effect::BREATHE, 0);
+  lamp.effects.renderFrame(100);
+  TEST_ASSERT_EQUAL_INT(0, lamp.fineSum());
+
+  TEST_ASSERT_TRUE(lamp.effects.applyFrame());
+  TEST_ASSERT_GREATER_THAN(0, lamp.fineSum());
+  // Taken once
+  TEST_ASSERT_FALSE(lamp.effects.applyFrame());
+}
+
+void test_frame_rendered_before_stop_is_dropped()
+{
+  Lamp lamp;
+  lamp.effects.setEffect(Effect::BREATHE, 0);
+  lamp.effects.renderFrame(100);
+  lamp.effects.stop();
+  TEST_ASSERT_FALSE(lamp.effects.applyFrame());
+  TEST_ASSERT_EQUAL_INT(0, lamp.fineSum());
+}
+
+void test_frame_from_previous_effect_is_dropped()
+{
+  Lamp lamp;
+  lamp.effects.setEffect(Effect::BREATHE, 0);
+  lamp.effects.renderFrame(100);
+  lamp.effects.setEffect(Effect::RAINBOW, 100);
+  TEST_ASSERT_FALSE(lamp.effects.applyFrame());
+
+  lamp.effects.renderFrame(110);
+  TEST_ASSERT_TRUE(lamp.effects.applyFrame());
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_render_alone_does_not_write);
+  RUN_TEST(test_frame_rendered_before_stop_is_dropped);
+  RUN_TEST(test_frame_from_previous_effect_is_dropped);
+  return UNITY_END();
+}
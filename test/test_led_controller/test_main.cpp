@@ -0,0 +1,93 @@
+// Host tests for the LED controller's power limits (pio test -e native):
+// the lamp as shipped, locked, in each knob and Home Assistant mode
+
+#include <unity.h>
+#include "HalFake.h"
+#include "SettingsStore.h"
+#include "PowerGovernor.h"
+#include "LedOutput.h"
+#include "TemporalDither.h"
+#include "LEDController.h"
+
+// Pin map and power model as in main.cpp and config.h
+constexpr LedPin LAMP_PINS[] = {{7, 0}, {6, 1}, {5, 2}};
+static const PowerChannel MODEL[COLOR_CHANNELS] = {{350, 2.2f}, {350, 3.2f}, {350, 3.2f}};
+static const uint32_t TAU_MS = 60000;
+static const uint32_t TICK_MS = 20;   // Control loop period
+
+struct Lamp
+{
+  SettingsStore settings{"led", 2000, 30000};
+  PowerGovernor governor{MODEL, TAU_MS, 0.8f};
+  LedOutput<LAMP_PINS> output;
+  TemporalDither dither{output};
+  LEDController controller{settings, governor, output, dither};
+
+  Lamp() { controller.begin(); }
+
+  // Full white held for durationMs in control ticks, from startMs
+  uint32_t holdWhite(uint32_t startMs, uint32_t durationMs)
+  {
+    controller.writeDutiesFine(PWM_FINE_MAX, PWM_FINE_MAX, PWM_FINE_MAX);
+    uint32_t t = startMs;
+    for (; t - startMs <= durationMs; t += TICK_MS)
+    {
+      controller.updatePower(t);
+    }
+    return t;
+  }
+
+  float delivered() const { return governor.getRequestedPower() * governor.getScale(); }
+};
+
+void setUp()
+{
+  hal::fake::reset();
+}
+
+void tearDown() {}
+
+// Locked bursts run above the mode's sustained limit, up to the locked
+// peak cap, then settle on the sustained limit
+static void checkLockedBurst(void (LEDController::*setMode)(), float sustained)
+{
+  Lamp lamp;
+  TEST_ASSERT_FALSE(lamp.controller.isUnlocked());
+  (lamp.controller.*setMode)();
+
+  uint32_t t = lamp.holdWhite(0, 5000);
+  TEST_ASSERT_GREATER_THAN(sustained + 0.1f, lamp.delivered());
+  TEST_ASSERT_TRUE(lamp.delivered() <= 0.8f + 0.001f);
+
+  lamp.holdWhite(t, 10 * TAU_MS);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, sustained, lamp.delivered());
+}
+
+void test_locked_mqtt_mode_bursts_above_sustained_limit()
+{
+  checkLockedBurst(&LEDController::setMQTTModePowerLimit, 0.6f);
+}
+
+void test_locked_rgb_mode_bursts_above_sustained_limit()
+{
+  checkLockedBurst(&LEDController::setRGBModePowerLimit, 0.3f);
+}
+
+// Unlocked, the only ceiling on a burst is the thermal model
+void test_unlocked_burst_runs_at_full_power()
+{
+  Lamp lamp;
+  lamp.controller.unlock();
+  lamp.controller.setMQTTModePowerLimit();
+  lamp.holdWhite(0, 5000);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 1.0f, lamp.governor.getScale());
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_locked_mqtt_mode_bursts_above_sustained_limit);
+  RUN_TEST(test_locked_rgb_mode_bursts_above_sustained_limit);
+  RUN_TEST(test_unlocked_burst_runs_at_full_power);
+  return UNITY_END();
+}
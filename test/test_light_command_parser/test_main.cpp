@@ -0,0 +1,76 @@
+// Host tests for the Home Assistant command parser (pio test -e native).
+// The payloads carry every key the filter keeps, so a filter or document
+// sized for the ESP32's 16-byte slots fails here on a 64-bit host.
+
+#include <string.h>
+#include <unity.h>
+#include "LightCommandParser.h"
+
+static LightCommandParser parser;
+
+static DeserializationError parse(const char* json, LightCommand& command)
+{
+  static char payload[256];
+  size_t length = strlen(json);
+  memcpy(payload, json, length);
+  return parser.parse(payload, length, command);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_full_payload_keeps_color()
+{
+  LightCommand command;
+  DeserializationError error = parse(
+      "{\"state\":\"ON\",\"color\":{\"r\":255,\"g\":180,\"b\":100},\"brightness\":200,"
+      "\"transition\":1.5,\"effect\":\"candle\",\"color_temp\":300}",
+      command);
+  TEST_ASSERT_FALSE(error);
+  TEST_ASSERT_TRUE(command.has(LightCommand::HAS_STATE));
+  TEST_ASSERT_TRUE(command.on);
+  TEST_ASSERT_TRUE(command.has(LightCommand::HAS_COLOR));
+  TEST_ASSERT_EQUAL_UINT8(255, command.red);
+  TEST_ASSERT_EQUAL_UINT8(180, command.green);
+  TEST_ASSERT_EQUAL_UINT8(100, command.blue);
+  TEST_ASSERT_TRUE(command.has(LightCommand::HAS_BRIGHTNESS));
+  TEST_ASSERT_EQUAL_UINT8(200, command.brightness);
+  TEST_ASSERT_TRUE(command.has(LightCommand::HAS_EFFECT));
+  TEST_ASSERT_TRUE(command.effect == Effect::CANDLE);
+  TEST_ASSERT_EQUAL_UINT32(1500, command.transitionMs);
+  // Color wins over a color temperature in the same payload
+  TEST_ASSERT_FALSE(command.has(LightCommand::HAS_COLOR_TEMP));
+}
+
+void test_unknown_keys_are_filtered()
+{
+  LightCommand command;
+  DeserializationError error = parse(
+      "{\"state\":\"ON\",\"color_mode\":\"rgb\",\"flash\":\"short\",\"white_value\":12,"
+      "\"color\":{\"r\":1,\"g\":2,\"b\":3,\"h\":40.5,\"s\":99.0,\"x\":0.3,\"y\":0.3},\"brightness\":7}",
+      command);
+  TEST_ASSERT_FALSE(error);
+  TEST_ASSERT_TRUE(command.has(LightCommand::HAS_COLOR));
+  TEST_ASSERT_EQUAL_UINT8(1, command.red);
+  TEST_ASSERT_EQUAL_UINT8(2, command.green);
+  TEST_ASSERT_EQUAL_UINT8(3, command.blue);
+  TEST_ASSERT_EQUAL_UINT8(7, command.brightness);
+}
+
+void test_color_temp_in_mireds()
+{
+  LightCommand command;
+  TEST_ASSERT_FALSE(parse("{\"color_temp\":370,\"brightness\":64}", command));
+  TEST_ASSERT_TRUE(command.has(LightCommand::HAS_COLOR_TEMP));
+  TEST_ASSERT_EQUAL_UINT16(2703, command.colorTempK);
+  TEST_ASSERT_FALSE(command.has(LightCommand::HAS_COLOR));
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_full_payload_keeps_color);
+  RUN_TEST(test_unknown_keys_are_filtered);
+  RUN_TEST(test_color_temp_in_mireds);
+  return UNITY_END();
+}
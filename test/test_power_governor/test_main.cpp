@@ -0,0 +1,97 @@
+// Host tests for the thermal power governor (pio test -e native)
+
+#include <unity.h>
+#include "PowerGovernor.h"
+
+// Power model and thermal constants as in config.h
+static const PowerChannel MODEL[COLOR_CHANNELS] = {{350, 2.2f}, {350, 3.2f}, {350, 3.2f}};
+static const uint32_t TAU_MS = 60000;
+static const uint32_t TICK_MS = 20;   // Control loop period
+
+static const int FULL_WHITE[COLOR_CHANNELS] = {PWM_MAX, PWM_MAX, PWM_MAX};
+
+// Holds duty for durationMs in control ticks, from startMs; returns the end time
+static uint32_t hold(PowerGovernor& governor, const int duty[COLOR_CHANNELS], uint32_t startMs, uint32_t durationMs)
+{
+  uint32_t t = startMs;
+  for (; t - startMs <= durationMs; t += TICK_MS)
+  {
+    governor.update(duty, t);
+  }
+  return t;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_cold_burst_runs_at_full_scale()
+{
+  PowerGovernor governor(MODEL, TAU_MS, 0.8f);
+  governor.setSustainedLimit(0.3f);
+  hold(governor, FULL_WHITE, 0, 5000);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.0f, governor.getScale());
+  TEST_ASSERT_EQUAL_INT(PWM_MAX, governor.scale(PWM_MAX));
+}
+
+void test_held_load_settles_at_sustained_limit()
+{
+  PowerGovernor governor(MODEL, TAU_MS, 0.8f);
+  governor.setSustainedLimit(0.3f);
+  hold(governor, FULL_WHITE, 0, 10 * TAU_MS);
+  float delivered = governor.getRequestedPower() * governor.getScale();
+  TEST_ASSERT_FLOAT_WITHIN(0.005f, 0.3f, delivered);
+  TEST_ASSERT_FLOAT_WITHIN(0.005f, 0.3f, governor.getHeat());
+}
+
+void test_scaling_keeps_hue_ratios()
+{
+  PowerGovernor governor(MODEL, TAU_MS, 0.8f);
+  governor.setSustainedLimit(0.3f);
+  const int warm[COLOR_CHANNELS] = {PWM_MAX, PWM_MAX / 2, PWM_MAX / 8};
+  hold(governor, warm, 0, 10 * TAU_MS);
+  TEST_ASSERT_LESS_THAN(0.9f, governor.getScale());
+
+  // One shared scale: each channel's share of the output is unchanged to
+  // within the rounding of one fine duty step
+  int fine[COLOR_CHANNELS];
+  for (int c = 0; c < COLOR_CHANNELS; c++)
+  {
+    fine[c] = governor.scale(warm[c] << DITHER_BITS);
+  }
+  for (int c = 1; c < COLOR_CHANNELS; c++)
+  {
+    float expected = static_cast<float>(warm[c]) / warm[0];
+    TEST_ASSERT_FLOAT_WITHIN(2.0f / fine[0], expected, static_cast<float>(fine[c]) / fine[0]);
+  }
+}
+
+void test_peak_limit_caps_every_write()
+{
+  PowerGovernor governor(MODEL, TAU_MS, 0.8f);
+  governor.setSustainedLimit(0.3f);
+  governor.setPeakLimit(0.3f);
+
+  // Cold, so the thermal model alone would allow a full burst
+  TEST_ASSERT_TRUE(governor.limitPeak(FULL_WHITE));
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.3f, governor.getScale());
+  // Already within the cap: nothing to do
+  TEST_ASSERT_FALSE(governor.limitPeak(FULL_WHITE));
+
+  hold(governor, FULL_WHITE, 0, 5000);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.3f, governor.getRequestedPower() * governor.getScale());
+
+  // Off again: the cap lifts the scale back through update()
+  const int dark[COLOR_CHANNELS] = {0, 0, 0};
+  hold(governor, dark, 5020, 100);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 1.0f, governor.getScale());
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_cold_burst_runs_at_full_scale);
+  RUN_TEST(test_held_load_settles_at_sustained_limit);
+  RUN_TEST(test_scaling_keeps_hue_ratios);
+  RUN_TEST(test_peak_limit_caps_every_write);
+  return UNITY_END();
+}
@@ -0,0 +1,80 @@
+// Host tests for the compile-time PWM tables (pio test -e native): the
+// gamma table and the Q15 channel trims against the float formulas they
+// replace
+
+#include <math.h>
+#include <unity.h>
+#include "PwmTables.h"
+#include "ColorPipeline.h"
+
+static const float TRIMS[COLOR_CHANNELS] = {RED_TRIM, GREEN_TRIM, BLUE_TRIM};
+
+static double gammaFine(int level)
+{
+  return pow(level / 255.0, LED_GAMMA) * PWM_FINE_MAX;
+}
+
+void setUp() {}
+void tearDown() {}
+
+// Rounded, so never more than half a fine step off
+void test_level_table_matches_pow()
+{
+  for (int level = 0; level < 256; level++)
+  {
+    double error = fabs(PWM_TABLES.level8Fine[level] - gammaFine(level));
+    TEST_ASSERT_TRUE_MESSAGE(error <= 0.5 + 1e-6, "level8Fine off by more than half a step");
+  }
+}
+
+void test_level_table_is_monotonic()
+{
+  for (int level = 1; level < 256; level++)
+  {
+    TEST_ASSERT_TRUE(PWM_TABLES.level8Fine[level] >= PWM_TABLES.level8Fine[level - 1]);
+  }
+  TEST_ASSERT_EQUAL_INT(0, PWM_TABLES.level8Fine[0]);
+  TEST_ASSERT_EQUAL_INT(PWM_FINE_MAX, PWM_TABLES.level8Fine[255]);
+}
+
+// The Q15 multiply truncates; within one fine step of the float trim
+void test_trim_matches_float()
+{
+  for (int c = 0; c < COLOR_CHANNELS; c++)
+  {
+    TEST_ASSERT_INT_WITHIN(1, static_cast<int>(lround(TRIMS[c] * 32768.0)), TRIM_Q15[c]);
+    for (int fine = 0; fine <= PWM_FINE_MAX; fine += 7)
+    {
+      TEST_ASSERT_INT_WITHIN(1, static_cast<int>(fine * TRIMS[c]), trimFine(c, fine));
+    }
+  }
+}
+
+// Color and brightness through the tables and the trim, against
+// pow(color) * pow(brightness) * trim in float
+void test_color8_pipeline_matches_float()
+{
+  for (int value = 0; value < 256; value += 5)
+  {
+    for (int brightness = 0; brightness < 256; brightness += 17)
+    {
+      const uint8_t rgb[COLOR_CHANNELS] = {static_cast<uint8_t>(value), static_cast<uint8_t>(255 - value), 128};
+      LinearColor duty = LampPipeline::run(color_source::fromColor8(rgb, static_cast<uint8_t>(brightness)));
+      for (int c = 0; c < COLOR_CHANNELS; c++)
+      {
+        double reference = gammaFine(rgb[c]) * gammaFine(brightness) / PWM_FINE_MAX * TRIMS[c];
+        TEST_ASSERT_TRUE_MESSAGE(fabs(duty.c[c] - reference) < 2.0, "pipeline off by two fine steps");
+      }
+    }
+  }
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_level_table_matches_pow);
+  RUN_TEST(test_level_table_is_monotonic);
+  RUN_TEST(test_trim_matches_float);
+  RUN_TEST(test_color8_pipeline_matches_float);
+  return UNITY_END();
+}
@@ -0,0 +1,133 @@
+// Host tests for the temporal dither (pio test -e native): every fraction
+// on a dim duty through the real set()/commit()/tick() path, sampled at the
+// LEDC channel
+
+#include <math.h>
+#include <unity.h>
+#include "HalFake.h"
+#include "LedOutput.h"
+#include "TemporalDither.h"
+
+// Tick as in config.h; 4000 samples are 1 s, a whole number of dither cycles
+static const double TICK_HZ = 1e6 / 250;
+static const int SAMPLES = 4000;
+
+constexpr LedPin PROBE_PINS[] = {{7, 0}};
+
+static double output[SAMPLES];
+
+// Ticks SAMPLES times with fine committed; returns the summed duty
+static uint32_t sample(uint16_t fine)
+{
+  LedOutput<PROBE_PINS> probe;
+  TemporalDither dither(probe);
+  probe.begin(19000, 11);
+  dither.start();
+  dither.set(0, fine);
+  dither.commit();
+
+  uint32_t sum = 0;
+  for (int i = 0; i < SAMPLES; i++)
+  {
+    dither.tick();
+    uint32_t duty = hal::fake::pwmDuty(probe.channel(0));
+    output[i] = duty;
+    sum += duty;
+  }
+  return sum;
+}
+
+// Lowest frequency carrying any ripple, 0 if the output is flat. DFT bins
+// are 1 Hz apart.
+static double lowestRippleHz(double mean)
+{
+  for (int bin = 1; bin <= SAMPLES / 2; bin++)
+  {
+    double re = 0.0;
+    double im = 0.0;
+    for (int i = 0; i < SAMPLES; i++)
+    {
+      double phase = 2.0 * M_PI * bin * i / SAMPLES;
+      re += (output[i] - mean) * cos(phase);
+      im -= (output[i] - mean) * sin(phase);
+    }
+    if (2.0 * sqrt(re * re + im * im) / SAMPLES > 1e-6)
+    {
+      return bin * TICK_HZ / SAMPLES;
+    }
+  }
+  return 0.0;
+}
+
+void setUp()
+{
+  hal::fake::reset();
+}
+
+void tearDown() {}
+
+void test_mean_is_the_fine_duty()
+{
+  for (int fraction = 0; fraction < TemporalDither::FRACTION_ONE; fraction++)
+  {
+    uint16_t fine = static_cast<uint16_t>((2 << DITHER_BITS) | fraction);
+    // Exactly, in whole steps: sum / SAMPLES == fine / FRACTION_ONE
+    TEST_ASSERT_EQUAL_UINT32(static_cast<uint32_t>(fine) * SAMPLES, sample(fine) * TemporalDither::FRACTION_ONE);
+  }
+}
+
+// Nothing below tickRate / 16, the ripple the eye could pick up as flicker
+void test_ripple_stays_above_the_floor()
+{
+  const double floorHz = TICK_HZ / TemporalDither::FRACTION_ONE;
+  for (int fraction = 1; fraction < TemporalDither::FRACTION_ONE; fraction++)
+  {
+    uint16_t fine = static_cast<uint16_t>((2 << DITHER_BITS) | fraction);
+    double lowestHz = lowestRippleHz(static_cast<double>(sample(fine)) / SAMPLES);
+    TEST_ASSERT_TRUE(lowestHz >= floorHz);
+  }
+}
+
+void test_whole_duty_is_flat_and_idles()
+{
+  LedOutput<PROBE_PINS> probe;
+  TemporalDither dither(probe);
+  probe.begin(19000, 11);
+  dither.start();
+  dither.set(0, 5 << DITHER_BITS);
+  dither.commit();
+  TEST_ASSERT_FALSE(dither.isIdle());
+
+  dither.tick();
+  TEST_ASSERT_TRUE(dither.isIdle());
+  TEST_ASSERT_EQUAL_UINT32(5, hal::fake::pwmDuty(probe.channel(0)));
+
+  // Idle ticks write nothing
+  uint32_t latches = hal::fake::pwmLatches();
+  for (int i = 0; i < 16; i++)
+  {
+    dither.tick();
+  }
+  TEST_ASSERT_EQUAL_UINT32(latches, hal::fake::pwmLatches());
+}
+
+// Before start() a commit latches the integer part straight away
+void test_commit_without_ticks_latches_integer_part()
+{
+  LedOutput<PROBE_PINS> probe;
+  TemporalDither dither(probe);
+  probe.begin(19000, 11);
+  dither.set(0, (9 << DITHER_BITS) | 7);
+  dither.commit();
+  TEST_ASSERT_EQUAL_UINT32(9, hal::fake::pwmDuty(probe.channel(0)));
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_mean_is_the_fine_duty);
+  RUN_TEST(test_ripple_stays_above_the_floor);
+  RUN_TEST(test_whole_duty_is_flat_and_idles);
+  RUN_TEST(test_commit_without_ticks_latches_integer_part);
+  return UNITY_END();
+}